@@ -0,0 +1,521 @@
+// batch.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Hashing of many (small) files. With io_uring up to BATCH_DEPTH files
+// are opened, read and closed asynchronously, and the sponges are run
+// as the reads complete; the system calls are made directly as there's
+// no liburing dependency. Without it, a pool of threads does the same
+// with ordinary calls, and takes over the files not yet printed if the
+// ring fails. Every sponge starts from a copy of one keyed state, and
+// the results are printed in the order of the arguments.
+
+#include "batch.h"
+#include <pthread.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#if defined(__NR_io_uring_setup) && defined(IO_URING_OP_SUPPORTED)
+#define BATCH_URING
+#endif
+#endif
+
+// per-file result
+typedef struct {
+    uint8_t md[CBYT_HASH];
+    int err;                                // errno, if not 0
+    int done;
+} batch_res_t;
+
+typedef struct {
+    char * const *fn;
+    int n;
+    sbob_t init;                            // keyed, empty state
+    batch_res_t *res;
+    int next, out;                          // next to start, to print
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+} batch_t;
+
+// print finished results in order. -1 at an error, 1 when all are done
+
+static int batch_print(batch_t *bt)
+{
+    int i;
+    batch_res_t *r;
+
+    for (; bt->out < bt->n && bt->res[bt->out].done; bt->out++) {
+        r = &bt->res[bt->out];
+        if (r->err != 0) {
+            errno = r->err;
+            perror(bt->fn[bt->out]);
+            return -1;
+        }
+        for (i = 0; i < CBYT_HASH; i++)
+            printf("%02x", r->md[i]);
+        printf("  %s\n", bt->fn[bt->out]);
+    }
+
+    return bt->out == bt->n;
+}
+
+// finish file i
+
+static void batch_done(batch_t *bt, int i, sbob_t *sb, int err)
+{
+    if (err == 0) {
+        sbob_fin(sb, BLNK_DAT);
+        sbob_get(sb, BLNK_HASH, bt->res[i].md, CBYT_HASH);
+    }
+    bt->res[i].err = err;
+    bt->res[i].done = 1;
+}
+
+#ifdef BATCH_URING
+
+// submission and completion rings
+typedef struct {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe *cqe;
+    void *sq_map, *cq_map;
+    size_t sq_len, cq_len, sqe_len;
+    unsigned pend;                          // queued, not submitted
+} batch_ring_t;
+
+// file states
+#define BATCH_IDLE  0
+#define BATCH_OPEN  1
+#define BATCH_READ  2
+#define BATCH_CLOSE 3
+
+typedef struct {
+    int state, i, fd, err;
+    uint64_t off;
+    sbob_t sb;
+    uint8_t *buf;
+} batch_slot_t;
+
+static void batch_ring_free(batch_ring_t *rg)
+{
+    if (rg->sqe != NULL)
+        munmap(rg->sqe, rg->sqe_len);
+    if (rg->cq_map != NULL && rg->cq_map != rg->sq_map)
+        munmap(rg->cq_map, rg->cq_len);
+    if (rg->sq_map != NULL)
+        munmap(rg->sq_map, rg->sq_len);
+    close(rg->fd);
+}
+
+// set up a ring supporting open, read and close. 0 on success
+
+static int batch_ring_init(batch_ring_t *rg, unsigned entries)
+{
+    int i;
+    uint8_t *sq, *cq;
+    struct io_uring_params p;
+    struct {
+        struct io_uring_probe h;
+        struct io_uring_probe_op op[256];
+    } pr;
+    static const int ops[3] = {
+        IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE
+    };
+
+    memset(rg, 0, sizeof(batch_ring_t));
+    memset(&p, 0, sizeof(p));
+    if ((rg->fd = syscall(__NR_io_uring_setup, entries, &p)) < 0)
+        return CBERRNO;
+
+    memset(&pr, 0, sizeof(pr));
+    if (syscall(__NR_io_uring_register, rg->fd, IORING_REGISTER_PROBE,
+        &pr, 256) != 0) {
+        close(rg->fd);
+        return CBERRNO;
+    }
+    for (i = 0; i < 3; i++) {
+        if (ops[i] > pr.h.last_op ||
+            !(pr.op[ops[i]].flags & IO_URING_OP_SUPPORTED)) {
+            close(rg->fd);
+            return CBERRNO;
+        }
+    }
+
+    // map the rings
+    rg->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    rg->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (rg->cq_len > rg->sq_len)
+            rg->sq_len = rg->cq_len;
+        rg->cq_len = rg->sq_len;
+    }
+    rg->sq_map = mmap(NULL, rg->sq_len, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, rg->fd, IORING_OFF_SQ_RING);
+    if (rg->sq_map == MAP_FAILED) {
+        rg->sq_map = NULL;
+        batch_ring_free(rg);
+        return CBERRNO;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        rg->cq_map = rg->sq_map;
+    } else {
+        rg->cq_map = mmap(NULL, rg->cq_len, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, rg->fd, IORING_OFF_CQ_RING);
+        if (rg->cq_map == MAP_FAILED) {
+            rg->cq_map = NULL;
+            batch_ring_free(rg);
+            return CBERRNO;
+        }
+    }
+    rg->sqe_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    rg->sqe = mmap(NULL, rg->sqe_len, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, rg->fd, IORING_OFF_SQES);
+    if (rg->sqe == MAP_FAILED) {
+        rg->sqe = NULL;
+        batch_ring_free(rg);
+        return CBERRNO;
+    }
+
+    sq = (uint8_t *) rg->sq_map;
+    cq = (uint8_t *) rg->cq_map;
+    rg->sq_head = (unsigned *) (sq + p.sq_off.head);
+    rg->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+    rg->sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+    rg->sq_array = (unsigned *) (sq + p.sq_off.array);
+    rg->cq_head = (unsigned *) (cq + p.cq_off.head);
+    rg->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+    rg->cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+    rg->cqe = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+
+    return 0;
+}
+
+// queue an operation for slot "s"; at most one per slot is in flight
+
+static void batch_sqe(batch_ring_t *rg, int op, int fd, const void *addr,
+    unsigned len, uint64_t off, int s)
+{
+    unsigned t, k;
+    struct io_uring_sqe *e;
+
+    t = *rg->sq_tail;
+    k = t & *rg->sq_mask;
+    e = &rg->sqe[k];
+    memset(e, 0, sizeof(struct io_uring_sqe));
+    e->opcode = op;
+    e->fd = fd;
+    e->addr = (uint64_t) (uintptr_t) addr;
+    e->len = len;
+    e->off = off;
+    if (op == IORING_OP_OPENAT)
+        e->open_flags = O_RDONLY;
+    e->user_data = s;
+    rg->sq_array[k] = k;
+    __atomic_store_n(rg->sq_tail, t + 1, __ATOMIC_RELEASE);
+    rg->pend++;
+}
+
+// next step for a slot
+
+static void batch_step(batch_t *bt, batch_ring_t *rg, batch_slot_t *sl,
+    int s)
+{
+    switch (sl->state) {
+
+        case BATCH_IDLE:                    // start the next file
+            if (bt->next >= bt->n)
+                return;
+            sl->i = bt->next++;
+            sl->off = 0;
+            sl->err = 0;
+            sl->sb = bt->init;
+            sl->state = BATCH_OPEN;
+            batch_sqe(rg, IORING_OP_OPENAT, AT_FDCWD, bt->fn[sl->i],
+                0, 0, s);
+            break;
+
+        case BATCH_READ:
+            batch_sqe(rg, IORING_OP_READ, sl->fd, sl->buf, BATCH_BUF,
+                sl->off, s);
+            break;
+
+        case BATCH_CLOSE:
+            batch_sqe(rg, IORING_OP_CLOSE, sl->fd, NULL, 0, 0, s);
+            break;
+    }
+}
+
+// handle a completion for slot "sl"
+
+static void batch_cqe(batch_t *bt, batch_slot_t *sl, int res)
+{
+    switch (sl->state) {
+
+        case BATCH_OPEN:
+            if (res < 0) {
+                batch_done(bt, sl->i, &sl->sb, -res);
+                sl->state = BATCH_IDLE;
+            } else {
+                sl->fd = res;
+                sl->state = BATCH_READ;
+            }
+            break;
+
+        case BATCH_READ:
+            if (res > 0) {
+                sbob_put(&sl->sb, BLNK_DAT, sl->buf, res);
+                sl->off += res;
+            } else {
+                sl->err = -res;
+                sl->state = BATCH_CLOSE;
+            }
+            break;
+
+        case BATCH_CLOSE:
+            batch_done(bt, sl->i, &sl->sb, sl->err);
+            sl->state = BATCH_IDLE;
+            break;
+    }
+}
+
+// the ring failed: close the files that are still ours, and unless there
+// was an error already, hand the ones not yet printed to the thread pool
+
+static void batch_abort(batch_t *bt, batch_ring_t *rg, batch_slot_t *sl,
+    int st)
+{
+    int i;
+    unsigned t;
+    struct io_uring_sqe *e;
+
+    for (i = 0; i < BATCH_DEPTH; i++) {
+        if (sl[i].state == BATCH_READ)
+            close(sl[i].fd);
+        memset(&sl[i].sb, 0, sizeof(sbob_t));
+    }
+
+    // the kernel closes what it was given; these it never saw
+    t = *rg->sq_tail;
+    for (; rg->pend > 0; rg->pend--) {
+        e = &rg->sqe[(t - rg->pend) & *rg->sq_mask];
+        if (e->opcode == IORING_OP_CLOSE)
+            close(e->fd);
+    }
+
+    if (st == 0) {
+        for (i = bt->out; i < bt->n; i++)
+            bt->res[i].done = 0;
+        bt->next = bt->out;
+    }
+}
+
+// the io_uring engine. CBERRNO if it is not available or fails; then
+// bt->next is below bt->n if the thread pool should do the rest
+
+static int batch_uring(batch_t *bt)
+{
+    int i, r, st, busy;
+    unsigned h, t;
+    const char *env;
+    batch_ring_t rg;
+    batch_slot_t sl[BATCH_DEPTH];
+    struct io_uring_cqe *e;
+
+    if ((env = getenv("STRIBOB_URING")) != NULL && strcmp(env, "0") == 0)
+        return CBERRNO;
+    if (batch_ring_init(&rg, BATCH_DEPTH) != 0)
+        return CBERRNO;
+
+    memset(sl, 0, sizeof(sl));
+    for (i = 0; i < BATCH_DEPTH; i++) {
+        if ((sl[i].buf = malloc(BATCH_BUF)) == NULL) {
+            while (--i >= 0)
+                free(sl[i].buf);
+            batch_ring_free(&rg);
+            return CBERRNO;
+        }
+    }
+
+    st = 0;
+    for (;;) {
+        // queue the next step of every slot that is waiting
+        for (i = 0; i < BATCH_DEPTH; i++) {
+            if (sl[i].state == BATCH_IDLE)
+                batch_step(bt, &rg, &sl[i], i);
+        }
+        for (i = 0, busy = 0; i < BATCH_DEPTH; i++)
+            busy += sl[i].state != BATCH_IDLE;
+        if (busy == 0)
+            break;
+
+        // submit and wait for at least one
+        if ((r = syscall(__NR_io_uring_enter, rg.fd, rg.pend, 1,
+            IORING_ENTER_GETEVENTS, NULL, 0)) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("io_uring_enter");
+            batch_abort(bt, &rg, sl, st);
+            batch_ring_free(&rg);           // buffers may be in use
+            return CBERRNO;
+        }
+        rg.pend -= r;
+
+        // completions
+        h = *rg.cq_head;
+        t = __atomic_load_n(rg.cq_tail, __ATOMIC_ACQUIRE);
+        for (; h != t; h++) {
+            e = &rg.cqe[h & *rg.cq_mask];
+            i = (int) e->user_data;
+            batch_cqe(bt, &sl[i], e->res);
+            if (sl[i].state != BATCH_IDLE)
+                batch_step(bt, &rg, &sl[i], i);
+        }
+        __atomic_store_n(rg.cq_head, h, __ATOMIC_RELEASE);
+
+        // on an error, start no more files but let these finish
+        if (st == 0 && batch_print(bt) < 0) {
+            st = CBERRNO;
+            bt->next = bt->n;
+        }
+    }
+
+    for (i = 0; i < BATCH_DEPTH; i++) {
+        memset(&sl[i].sb, 0, sizeof(sbob_t));
+        free(sl[i].buf);
+    }
+    batch_ring_free(&rg);
+
+    return st;
+}
+
+#endif
+
+// thread pool worker
+
+static void *batch_work(void *arg)
+{
+    int i, fd, len, err;
+    uint8_t *buf;
+    sbob_t sb;
+    batch_t *bt = (batch_t *) arg;
+
+    // without a buffer, fail the next file so that the printer stops
+    if ((buf = malloc(BATCH_BUF)) == NULL) {
+        pthread_mutex_lock(&bt->mtx);
+        if (bt->next < bt->n && bt->out >= 0)
+            batch_done(bt, bt->next++, NULL, ENOMEM);
+        pthread_cond_broadcast(&bt->cv);
+        pthread_mutex_unlock(&bt->mtx);
+        return NULL;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&bt->mtx);
+        if (bt->next >= bt->n || bt->out < 0) {
+            pthread_mutex_unlock(&bt->mtx);
+            break;
+        }
+        i = bt->next++;
+        pthread_mutex_unlock(&bt->mtx);
+
+        sb = bt->init;
+        err = 0;
+        if ((fd = open(bt->fn[i], O_RDONLY)) == -1) {
+            err = errno;
+        } else {
+            while ((len = read(fd, buf, BATCH_BUF)) > 0)
+                sbob_put(&sb, BLNK_DAT, buf, len);
+            if (len < 0)
+                err = errno;
+            close(fd);
+        }
+
+        pthread_mutex_lock(&bt->mtx);
+        batch_done(bt, i, &sb, err);
+        pthread_cond_broadcast(&bt->cv);
+        pthread_mutex_unlock(&bt->mtx);
+    }
+    memset(&sb, 0, sizeof(sb));
+    free(buf);
+
+    return NULL;
+}
+
+// the thread pool; this thread prints
+
+static int batch_pool(batch_t *bt, int threads)
+{
+    int i, k, st;
+    pthread_t *tid;
+
+    if ((tid = malloc(threads * sizeof(pthread_t))) == NULL)
+        return CBERRNO;
+    for (k = 0; k < threads; k++) {
+        if (pthread_create(&tid[k], NULL, batch_work, bt) != 0)
+            break;
+    }
+    if (k == 0) {
+        free(tid);
+        return CBERRNO;
+    }
+
+    pthread_mutex_lock(&bt->mtx);
+    while ((st = batch_print(bt)) == 0)
+        pthread_cond_wait(&bt->cv, &bt->mtx);
+    if (st < 0)
+        bt->out = -1;                       // stop the workers
+    pthread_mutex_unlock(&bt->mtx);
+
+    for (i = 0; i < k; i++)
+        pthread_join(tid[i], NULL);
+    free(tid);
+
+    return st < 0 ? CBERRNO : 0;
+}
+
+// hash a list of files
+
+int batch_hash(stricat_t *cx, int keyed, char * const fn[], int n,
+    int threads)
+{
+    int st;
+    batch_t bt;
+
+    memset(&bt, 0, sizeof(bt));
+    bt.fn = fn;
+    bt.n = n;
+    if ((bt.res = calloc(n, sizeof(batch_res_t))) == NULL)
+        return CBERRNO;
+
+    // the key is absorbed once
+    sbob_clr(&bt.init);
+    if (keyed) {
+        sbob_put(&bt.init, BLNK_KEY, cx->key, CBYT_KEY);
+        sbob_fin(&bt.init, BLNK_KEY);
+    }
+
+    // io_uring if available, threads otherwise or for what a failed
+    // ring left unprinted
+#ifdef BATCH_URING
+    if ((st = batch_uring(&bt)) == 0 || bt.next >= bt.n)
+        goto done;
+#endif
+    pthread_mutex_init(&bt.mtx, NULL);
+    pthread_cond_init(&bt.cv, NULL);
+    st = batch_pool(&bt, threads);
+    pthread_cond_destroy(&bt.cv);
+    pthread_mutex_destroy(&bt.mtx);
+
+#ifdef BATCH_URING
+done:
+#endif
+    memset(&bt.init, 0, sizeof(sbob_t));
+    memset(bt.res, 0, n * sizeof(batch_res_t));
+    free(bt.res);
+
+    return st;
+}
@@ -0,0 +1,21 @@
+// batch.h
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "blnk.h"
+
+// files in flight and the read size for each
+#define BATCH_DEPTH 64
+#define BATCH_BUF   0x10000
+
+// -s hash of files fn[0..n-1], keyed with cx->key if "keyed", printed
+// in argument order like the plain loop. io_uring (set STRIBOB_URING=0
+// to disable) or a pool of "threads" threads. stops at the first file
+// that can't be read
+int batch_hash(stricat_t *cx, int keyed, char * const fn[], int n,
+    int threads);
+
+#endif
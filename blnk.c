@@ -8,14 +8,11 @@
 
 // simple conversions
 
-uint64_t blnk_lbf_getl(stricat_t *cx, int from)
+uint64_t blnk_lbf_getl(stricat_t *cx)
 {
     int i;
     uint64_t x;
 
-    sbob_put(&cx->sbx, BLNK_AAD | from, cx->lbf, CBYT_LBUF);
-    sbob_fin(&cx->sbx, BLNK_AAD | from);
-
     x = 0;
     for (i = 0; i < CBYT_LBUF; i++) {
         x += ((uint64_t) cx->lbf[i]) << (8lu * i);
@@ -30,7 +27,7 @@ uint64_t blnk_lbf_getl(stricat_t *cx, int from)
     return x;
 }
 
-void blnk_lbf_putl(stricat_t *cx, uint64_t x, int from)
+void blnk_lbf_putl(stricat_t *cx, uint64_t x)
 {
     int i;
 
@@ -38,9 +35,16 @@ void blnk_lbf_putl(stricat_t *cx, uint64_t x, int from)
         cx->lbf[i] = x & 0xFF;
         x >>= 8lu;
     }
+}
+
+void blnk_hole_ad(uint8_t ad[CBYT_LBUF + CBYT_HOLE], uint64_t len)
+{
+    int i;
 
-    sbob_put(&cx->sbx, BLNK_AAD | from, cx->lbf, CBYT_LBUF);
-    sbob_fin(&cx->sbx, BLNK_AAD | from);
+    for (i = 0; i < CBYT_LBUF; i++)
+        ad[i] = (BLNK_HOLE >> (8 * i)) & 0xFF;
+    for (i = 0; i < CBYT_HOLE; i++)
+        ad[CBYT_LBUF + i] = (len >> (8 * i)) & 0xFF;
 }
 
 // fill buffer with real random
@@ -81,30 +85,73 @@ int block_send(stricat_t *cx, const void *buf, int len)
     return len;
 }
 
-// blocking receive
+// send a record (or several) in one go
+
+int block_sendv(stricat_t *cx, struct iovec *iov, int iovcnt)
+{
+    ssize_t n;
+    struct msghdr msg;
+
+    while (iovcnt > 0) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        n = sendmsg(cx->sck, &msg, 0);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                usleep(10000);
+                continue;
+            }
+            if (errno == EINTR)
+                continue;
+            perror("block_sendv()");
+            return CBERRNO;
+        }
+        while (iovcnt > 0 && (size_t) n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = ((uint8_t *) iov->iov_base) + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    return 0;
+}
+
+// blocking receive, through the read-ahead buffer
 
 int block_recv(stricat_t *cx, void *buf, int len)
 {
     int i, n;
 
-
     for (i = 0; i < len; i += n) {
-        n = recv(cx->sck, &((char *) buf)[i], len - i, 0);
-        if (n == 0) {   // orderly shutdown
-            fprintf(stderr, "Channel shutdown.\n");
-            return i;
-        }
-        if (n < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                n = 0;
-            } else {
-                perror("block_recv()");
+        if (cx->rap >= cx->ral) {
+            n = recv(cx->sck, cx->rab, CBYT_RAHD, 0);
+            if (n == 0) {   // orderly shutdown
+                fprintf(stderr, "Channel shutdown.\n");
                 return i;
             }
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    usleep(10000);
+                } else if (errno != EINTR) {
+                    perror("block_recv()");
+                    return i;
+                }
+                n = 0;
+                continue;
+            }
+            cx->rap = 0;
+            cx->ral = n;
         }
-        usleep(10000);
+        n = len - i < cx->ral - cx->rap ? len - i : cx->ral - cx->rap;
+        memcpy(&((char *) buf)[i], &cx->rab[cx->rap], n);
+        cx->rap += n;
     }
- 
+
     return len;
 }
 
@@ -112,23 +159,20 @@ int block_recv(stricat_t *cx, void *buf, int len)
 
 int blnk_send(stricat_t *cx, int from, int len)
 {
-    // encode length
-    blnk_lbf_putl(cx, len, from);  
-    if (block_send(cx, cx->lbf, CBYT_LBUF) != CBYT_LBUF)
-        return CBERRNO;
-
-    // encrypt
-    if (len > 0) {
-        sbob_enc(&cx->sbx, BLNK_MSG | from, cx->xfr, cx->xfr, len);
-        sbob_fin(&cx->sbx, BLNK_MSG | from);
-        if (block_send(cx, cx->xfr, len) != len)
-            return CBERRNO;
-    }
- 
-    // MAC
-    sbob_get(&cx->sbx, BLNK_MAC | from, cx->mac, CBYT_MAC);
-    sbob_fin(&cx->sbx, BLNK_MAC | from);
-    if (block_send(cx, cx->mac, CBYT_MAC) != CBYT_MAC)
+    struct iovec iov[3];
+
+    // length as AAD, encrypt, MAC
+    blnk_lbf_putl(cx, len);
+    sbob_seal(&cx->sbx, from, cx->lbf, CBYT_LBUF,
+        cx->xfr, cx->xfr, len, cx->mac, CBYT_MAC);
+
+    iov[0].iov_base = cx->lbf;
+    iov[0].iov_len = CBYT_LBUF;
+    iov[1].iov_base = cx->xfr;
+    iov[1].iov_len = len;
+    iov[2].iov_base = cx->mac;
+    iov[2].iov_len = CBYT_MAC;
+    if (block_sendv(cx, iov, 3) != 0)
         return CBERRNO;
 
     return len;
@@ -138,18 +182,21 @@ int blnk_send(stricat_t *cx, int from, int len)
 
 int blnk_term(stricat_t *cx, int from)
 {
+    struct iovec iov[2];
+
     // set local terminator
     cx->run = 0;
 
     // ~0 is the terminate signal
-    blnk_lbf_putl(cx, BLNK_TERMINATE, from);  
-    if (block_send(cx, cx->lbf, CBYT_LBUF) != CBYT_LBUF)
-        return CBERRNO;
-
-    // MAC
-    sbob_get(&cx->sbx, BLNK_MAC | from, cx->mac, CBYT_MAC);
-    sbob_fin(&cx->sbx, BLNK_MAC | from);
-    if (block_send(cx, cx->mac, CBYT_MAC) != CBYT_MAC)
+    blnk_lbf_putl(cx, BLNK_TERMINATE);
+    sbob_seal(&cx->sbx, from, cx->lbf, CBYT_LBUF,
+        NULL, NULL, 0, cx->mac, CBYT_MAC);
+
+    iov[0].iov_base = cx->lbf;
+    iov[0].iov_len = CBYT_LBUF;
+    iov[1].iov_base = cx->mac;
+    iov[1].iov_len = CBYT_MAC;
+    if (block_sendv(cx, iov, 2) != 0)
         return CBERRNO;
 
     return 0;
@@ -166,7 +213,7 @@ int blnk_recv(stricat_t *cx, int from)
     if (len != CBYT_LBUF) {
         return CBERRNO;
     }
-    len = blnk_lbf_getl(cx, from);
+    len = blnk_lbf_getl(cx);
 
     if (len < 0 || len > CBYT_XFER)
         return CBERRNO;
@@ -174,16 +221,82 @@ int blnk_recv(stricat_t *cx, int from)
     if (len > 0) {
         if (block_recv(cx, cx->xfr, len) != len)
             return CBERRNO;
-        sbob_dec(&cx->sbx, BLNK_MSG | from, cx->xfr, cx->xfr, len);
-        sbob_fin(&cx->sbx, BLNK_MSG | from);
     }
+    if (block_recv(cx, cx->mac, CBYT_MAC) != CBYT_MAC)
+        return CBERRNO;
+
+    // decrypt and compare MAC
+    if (sbob_open(&cx->sbx, from, cx->lbf, CBYT_LBUF,
+        cx->xfr, cx->xfr, len, cx->mac, CBYT_MAC) != 0)
+        return CBERRNO;
+
+    return len;
+}
+
+// scatter-gather send; the fragments are encrypted in place
+
+int blnk_sendv(stricat_t *cx, int from, const struct iovec *iov, int iovcnt)
+{
+    int i, n, len;
+    struct iovec v[BLNK_IOV + 1];
+
+    len = 0;
+    for (i = 0; i < iovcnt; i++)
+        len += iov[i].iov_len;
+    if (len > CBYT_XFER)
+        return CBERRNO;
 
-    // MAC compare
+    blnk_lbf_putl(cx, len);
+    sbob_sealv(&cx->sbx, from, cx->lbf, CBYT_LBUF,
+        iov, iovcnt, cx->mac, CBYT_MAC);
+
+    // BLNK_IOV fragments per call, usually all of them
+    n = 0;
+    v[n].iov_base = cx->lbf;
+    v[n++].iov_len = CBYT_LBUF;
+    for (i = 0; i < iovcnt; i++) {
+        if (n == BLNK_IOV) {
+            if (block_sendv(cx, v, n) != 0)
+                return CBERRNO;
+            n = 0;
+        }
+        v[n++] = iov[i];
+    }
+    v[n].iov_base = cx->mac;
+    v[n++].iov_len = CBYT_MAC;
+    if (block_sendv(cx, v, n) != 0)
+        return CBERRNO;
+
+    return len;
+}
+
+// scatter-gather receive; the record must fill the fragments exactly
+
+int blnk_recvv(stricat_t *cx, int from, const struct iovec *iov, int iovcnt)
+{
+    int i, len;
+
+    if (block_recv(cx, cx->lbf, CBYT_LBUF) != CBYT_LBUF)
+        return CBERRNO;
+    len = blnk_lbf_getl(cx);
+
+    for (i = 0; i < iovcnt; i++)
+        len -= iov[i].iov_len;
+    if (len != 0)
+        return CBERRNO;
+
+    for (i = 0; i < iovcnt; i++) {
+        if (block_recv(cx, iov[i].iov_base, iov[i].iov_len) !=
+            (int) iov[i].iov_len)
+            return CBERRNO;
+        len += iov[i].iov_len;
+    }
     if (block_recv(cx, cx->mac, CBYT_MAC) != CBYT_MAC)
         return CBERRNO;
-    if (sbob_cmp(&cx->sbx, BLNK_MAC | from, cx->mac, CBYT_MAC) != 0)
+
+    if (sbob_openv(&cx->sbx, from, cx->lbf, CBYT_LBUF,
+        iov, iovcnt, cx->mac, CBYT_MAC) != 0)
         return CBERRNO;
-    sbob_fin(&cx->sbx, BLNK_MAC | from);
 
     return len;
 }
@@ -35,6 +35,10 @@
 #define BLNK_TERMINATE (~0lu)
 #endif
 
+// .sb1 zero-run record: this length, a 64-bit run length and the MAC
+#define BLNK_HOLE 0xFFFFFFFEu
+#define CBYT_HOLE 8
+
 // application parameters
 #define CBYT_KEY 24
 #define CBYT_NPUB 16
@@ -43,6 +47,11 @@
 #define CBYT_LBUF 4
 #define CBYT_HASH 16
 #define CBYT_XFER 0x10000
+#define CBYT_RAHD (2 * CBYT_XFER)
+#define CBYT_XMAX 0x1000000     // longest .sb1 record
+
+// most fragments per sendmsg() in blnk_sendv()
+#define BLNK_IOV 16
 
 typedef struct {
     int     sck;                // network socket
@@ -55,18 +64,31 @@ typedef struct {
     uint8_t lbf[CBYT_LBUF];     // 32-bit length buffer
     uint8_t nnc[CBYT_NPUB];     // nonce
     char    xfr[CBYT_XFER];     // input-output buffer
+    size_t  blk;                // .sb1 / .sb2 chunk size, 0 = default
+    int     hole;               // store holes as zero-run records
+    int     rap, ral;           // read-ahead position and length
+    uint8_t rab[CBYT_RAHD];     // read-ahead from sck
 } stricat_t;
 
 // a send function that waits for buffers to clear (success only if "len" sent)
 int block_send(stricat_t *cx, const void *buf, int len);
 
-// blocks until exactly "len" bytes has been received
+// send all of iov with sendmsg(), adjusting it on partial sends. 0 on
+// success
+int block_sendv(stricat_t *cx, struct iovec *iov, int iovcnt);
+
+// blocks until exactly "len" bytes has been received; reads ahead
 int block_recv(stricat_t *cx, void *buf, int len);
 
 // authenticated and ecnryptiond send & receive - use cx->xfr buffer
 int blnk_send(stricat_t *cx, int from, int len);
 int blnk_recv(stricat_t *cx, int from);
 
+// the same with fragmented buffers, which are en/decrypted in place.
+// blnk_recvv() fails unless the record length equals their total length
+int blnk_sendv(stricat_t *cx, int from, const struct iovec *iov, int iovcnt);
+int blnk_recvv(stricat_t *cx, int from, const struct iovec *iov, int iovcnt);
+
 // send a terminator which is understood by blnk_recv()
 int blnk_term(stricat_t *cx, int from);
 
@@ -82,8 +104,11 @@ int blnk_shake_bobby(stricat_t *cx, const uint8_t bobby[CBYT_IDNT]);
 
 // utility functions
 int blnk_rand(void *buf, int len);
-uint64_t blnk_lbf_getl(stricat_t *cx, int from);
-void blnk_lbf_putl(stricat_t *cx, uint64_t x, int from);
+uint64_t blnk_lbf_getl(stricat_t *cx);              // decode cx->lbf
+void blnk_lbf_putl(stricat_t *cx, uint64_t x);      // encode to cx->lbf
+
+// the AAD of a zero-run record of "len" bytes: BLNK_HOLE and the length
+void blnk_hole_ad(uint8_t ad[CBYT_LBUF + CBYT_HOLE], uint64_t len);
 
 // selftest.c
 int run_selftest();
@@ -0,0 +1,733 @@
+// ckpt.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Resumable hashing of append-only files. The mid-stream hash state is
+// kept in a sidecar file next to the input with the byte offset and a
+// fingerprint of the prefix; the next run checks those, restores the
+// state and only hashes what was appended. The prefix is trusted to be
+// unchanged: the fingerprint only covers its ends and the file identity.
+//
+// Sidecar: header (CKPT_HDR: "sbr2", mode, 3 zero bytes, 64-bit offset,
+// fingerprint), nonce, state and tag. The state is sealed with the
+// header as AAD, under the hash key for keyed STRIBOB hashes. Unkeyed
+// sidecars can be recomputed by anyone, so they are not tamper-proof.
+//
+// The decryption index of a .sb1 file is another sidecar, FILE.sb1.sbx:
+// header (CKPT_IHDR: "sbx1", interval, 64-bit entry count, .sb1 nonce),
+// nonce, entries and tag. Each entry (CKPT_ENT) is the record number,
+// ciphertext and plaintext offsets and the saved state. The entries are
+// sealed with the header as AAD under the file key, so the index can
+// only be used, or forged, by those who could decrypt the file anyway.
+
+#include "ckpt.h"
+#include "iocom.h"
+#include "ring.h"
+#include "streebog.h"
+#include <pthread.h>
+
+#define CKPT_HDR (8 + 8 + CKPT_FP)
+#define CKPT_TAG 16
+#define CKPT_MAX (CKPT_HDR + CBYT_NPUB + STREEBOG_SAVE + CKPT_TAG)
+#define CKPT_IHDR (16 + CBYT_NPUB)
+#define CKPT_ENT (24 + SBOB_SAVE)
+
+// sidecar file name for this mode
+
+static void ckpt_name(char *side, size_t siz, const char *fn, int mode)
+{
+    snprintf(side, siz, "%s.%s", fn,
+        mode == 's' ? "sbs" : mode == 'g' ? "sg256" : "sg512");
+}
+
+// fingerprint of the first "off" bytes: the device and inode of fd, the
+// offset and up to CKPT_EDGE bytes from both ends. only detects changes
+// near the ends, or a file replaced by another one
+
+static int ckpt_fp(int fd, uint64_t off, uint8_t fp[CKPT_FP])
+{
+    int i;
+    size_t len;
+    uint64_t x;
+    uint8_t buf[CKPT_EDGE];
+    struct stat st;
+    sbob_t sb;
+
+    if (fstat(fd, &st) != 0)
+        return CBERRNO;
+    sbob_clr(&sb);
+    for (i = 0; i < 24; i++) {
+        x = i < 8 ? (uint64_t) st.st_dev :
+            i < 16 ? (uint64_t) st.st_ino : off;
+        buf[i] = x >> (8 * (i & 7));
+    }
+    sbob_put(&sb, BLNK_AAD, buf, 24);
+    sbob_fin(&sb, BLNK_AAD);
+
+    len = off < CKPT_EDGE ? off : CKPT_EDGE;
+    if (pread(fd, buf, len, 0) != (ssize_t) len)
+        return CBERRNO;
+    sbob_put(&sb, BLNK_DAT, buf, len);
+    sbob_fin(&sb, BLNK_DAT);
+    if (pread(fd, buf, len, off - len) != (ssize_t) len)
+        return CBERRNO;
+    sbob_put(&sb, BLNK_DAT, buf, len);
+    sbob_fin(&sb, BLNK_DAT);
+    sbob_get(&sb, BLNK_HASH, fp, CKPT_FP);
+
+    return 0;
+}
+
+// sponge for sealing a sidecar
+
+static void ckpt_init(sbob_t *sb, const uint8_t *key, const uint8_t *nnc)
+{
+    sbob_clr(sb);
+    if (key != NULL) {
+        sbob_put(sb, BLNK_KEY, key, CBYT_KEY);
+        sbob_fin(sb, BLNK_KEY);
+    }
+    sbob_put(sb, BLNK_NPUB, nnc, CBYT_NPUB);
+    sbob_fin(sb, BLNK_NPUB);
+}
+
+// replace a sidecar file atomically. the temporary file gets a fresh
+// name (mkstemp: O_EXCL, mode 0600), so nothing planted in a shared
+// directory is followed or overwritten
+
+static int ckpt_write(const char *side, const uint8_t *buf, size_t len)
+{
+    int fs;
+    char tmp[CBYT_XFER + 8];
+
+    snprintf(tmp, sizeof(tmp), "%s.XXXXXX", side);
+    if ((fs = mkstemp(tmp)) == -1) {
+        perror(tmp);
+        return CBERRNO;
+    }
+    if (write(fs, buf, len) != (ssize_t) len) {
+        perror(tmp);
+        close(fs);
+        unlink(tmp);
+        return CBERRNO;
+    }
+    close(fs);
+    if (rename(tmp, side) != 0) {
+        perror(side);
+        unlink(tmp);
+        return CBERRNO;
+    }
+
+    return 0;
+}
+
+// write the "len"-byte state at offset "off" of fd
+
+static int ckpt_save(const char *side, int mode, const uint8_t *key,
+    int fd, uint64_t off, const uint8_t *st, size_t len)
+{
+    int i;
+    uint8_t rec[CKPT_MAX];
+    sbob_t sb;
+
+    memset(rec, 0, CKPT_HDR);
+    memcpy(rec, "sbr2", 4);
+    rec[4] = mode;
+    for (i = 0; i < 8; i++)
+        rec[8 + i] = off >> (8 * i);
+    if (ckpt_fp(fd, off, &rec[16]) != 0)
+        return CBERRNO;
+
+    blnk_rand(&rec[CKPT_HDR], CBYT_NPUB);
+    ckpt_init(&sb, key, &rec[CKPT_HDR]);
+    sbob_seal(&sb, 0, rec, CKPT_HDR, &rec[CKPT_HDR + CBYT_NPUB], st, len,
+        &rec[CKPT_HDR + CBYT_NPUB + len], CKPT_TAG);
+    memset(&sb, 0, sizeof(sb));
+
+    return ckpt_write(side, rec, len + CKPT_HDR + CBYT_NPUB + CKPT_TAG);
+}
+
+// read back a state for fd of "size" bytes. 0 if it is valid
+
+static int ckpt_load(const char *side, int mode, const uint8_t *key,
+    int fd, uint64_t size, uint64_t *off, uint8_t *st, size_t len)
+{
+    int i, fs, d;
+    uint8_t rec[CKPT_MAX + 1], fp[CKPT_FP];
+    sbob_t sb;
+
+    if ((fs = open(side, O_RDONLY)) == -1)
+        return CBERRNO;
+    i = read(fs, rec, sizeof(rec));
+    close(fs);
+
+    if (i != (int) (CKPT_HDR + CBYT_NPUB + len + CKPT_TAG) ||
+        memcmp(rec, "sbr2", 4) != 0 || rec[4] != mode)
+        return CBERRNO;
+    *off = 0;
+    for (i = 7; i >= 0; i--)
+        *off = (*off << 8) | rec[8 + i];
+    if (*off > size || ckpt_fp(fd, *off, fp) != 0 ||
+        memcmp(fp, &rec[16], CKPT_FP) != 0)
+        return CBERRNO;
+
+    ckpt_init(&sb, key, &rec[CKPT_HDR]);
+    d = sbob_open(&sb, 0, rec, CKPT_HDR, st, &rec[CKPT_HDR + CBYT_NPUB],
+        len, &rec[CKPT_HDR + CBYT_NPUB + len], CKPT_TAG);
+    memset(&sb, 0, sizeof(sb));
+    memset(rec, 0, sizeof(rec));
+
+    return d;
+}
+
+// resumable hash of a file
+
+int ckpt_hash(stricat_t *cx, const char *fn, int mode, int keyed)
+{
+    int fd, len, st;
+    size_t slen;
+    uint64_t off;
+    char side[CBYT_XFER];
+    uint8_t buf[STREEBOG_SAVE];
+    const uint8_t *key;
+    struct stat sst;
+    streebog_t sbog;
+
+    if ((fd = open(fn, O_RDONLY)) == -1 || fstat(fd, &sst) != 0) {
+        perror(fn);
+        if (fd != -1)
+            close(fd);
+        return CBERRNO;
+    }
+    ckpt_name(side, sizeof(side), fn, mode);
+    key = mode == 's' && keyed ? cx->key : NULL;
+    slen = mode == 's' ? SBOB_SAVE : STREEBOG_SAVE;
+
+    // restore, or start from the beginning
+    st = ckpt_load(side, mode, key, fd, sst.st_size, &off, buf, slen);
+    if (st == 0) {
+        if (mode == 's')
+            st = sbob_load(&cx->sbx, buf);
+        else if (streebog_load(&sbog, buf) == 0 ||
+            sbog.hlen != (mode == 'g' ? 32 : 64))
+            st = CBERRNO;
+    }
+    if (st == 0 && lseek(fd, off, SEEK_SET) != (off_t) off)
+        st = CBERRNO;
+    if (st != 0) {
+        off = 0;
+        if (mode == 's') {
+            sbob_clr(&cx->sbx);
+            if (key != NULL) {
+                sbob_put(&cx->sbx, BLNK_KEY, key, CBYT_KEY);
+                sbob_fin(&cx->sbx, BLNK_KEY);
+            }
+        } else {
+            streebog_init(&sbog, mode == 'g' ? 32 : 64);
+        }
+    }
+
+    // the rest
+    while ((len = read(fd, cx->xfr, CBYT_XFER)) > 0) {
+        if (mode == 's')
+            sbob_put(&cx->sbx, BLNK_DAT, cx->xfr, len);
+        else
+            streebog_update(&sbog, cx->xfr, len);
+        off += len;
+    }
+    if (len < 0) {
+        perror(fn);
+        close(fd);
+        return CBERRNO;
+    }
+
+    // save and finish
+    if (mode == 's')
+        sbob_save(&cx->sbx, buf);
+    else
+        streebog_save(&sbog, buf);
+    ckpt_save(side, mode, key, fd, off, buf, slen);   // not fatal
+    memset(buf, 0, sizeof(buf));
+    close(fd);
+
+    if (mode == 's') {
+        sbob_fin(&cx->sbx, BLNK_DAT);
+        sbob_get(&cx->sbx, BLNK_HASH, cx->xfr, CBYT_HASH);
+    } else {
+        streebog_final(cx->xfr, &sbog);
+    }
+
+    return 0;
+}
+
+// little-endian fields of the index
+
+static void ckpt_put64(uint8_t *p, uint64_t x)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        p[i] = x >> (8 * i);
+}
+
+static uint64_t ckpt_get64(const uint8_t *p)
+{
+    int i;
+    uint64_t x;
+
+    x = 0;
+    for (i = 7; i >= 0; i--)
+        x = (x << 8) | p[i];
+
+    return x;
+}
+
+// add an index entry; on a memory error there's just no index
+
+void ckpt_idx_add(ckpt_idx_t *ix, const sbob_t *sb, uint64_t rec,
+    uint64_t coff, uint64_t poff)
+{
+    ckpt_ent_t *p;
+
+    if (ix == NULL || ix->every == 0 || rec % ix->every != 0)
+        return;
+    if (ix->n >= ix->cap) {
+        ix->cap = ix->cap == 0 ? 64 : 2 * ix->cap;
+        if ((p = realloc(ix->ent, ix->cap * sizeof(ckpt_ent_t))) == NULL) {
+            ckpt_idx_free(ix);
+            return;
+        }
+        ix->ent = p;
+    }
+    p = &ix->ent[ix->n++];
+    p->rec = rec;
+    p->coff = coff;
+    p->poff = poff;
+    sbob_save(sb, p->st);
+}
+
+void ckpt_idx_free(ckpt_idx_t *ix)
+{
+    if (ix->ent != NULL) {
+        memset(ix->ent, 0, ix->cap * sizeof(ckpt_ent_t));
+        free(ix->ent);
+    }
+    memset(ix, 0, sizeof(ckpt_idx_t));
+}
+
+// header of the index
+
+static void ckpt_idx_hdr(uint8_t *hdr, const ckpt_idx_t *ix,
+    const uint8_t nnc[CBYT_NPUB])
+{
+    memcpy(hdr, "sbx1", 4);
+    hdr[4] = ix->every;
+    hdr[5] = ix->every >> 8;
+    hdr[6] = ix->every >> 16;
+    hdr[7] = ix->every >> 24;
+    ckpt_put64(&hdr[8], ix->n);
+    memcpy(&hdr[16], nnc, CBYT_NPUB);
+}
+
+// seal and write the index
+
+int ckpt_idx_save(ckpt_idx_t *ix, const char *fn, const uint8_t *key,
+    const uint8_t nnc[CBYT_NPUB])
+{
+    int st;
+    size_t i, len;
+    char side[CBYT_XFER];
+    uint8_t *buf, *p;
+    sbob_t sb;
+
+    if (ix->every == 0 || ix->n == 0)
+        return CBERRNO;
+    len = CKPT_IHDR + CBYT_NPUB + ix->n * CKPT_ENT + CKPT_TAG;
+    if ((buf = malloc(len)) == NULL)
+        return CBERRNO;
+
+    ckpt_idx_hdr(buf, ix, nnc);
+    blnk_rand(&buf[CKPT_IHDR], CBYT_NPUB);
+    p = &buf[CKPT_IHDR + CBYT_NPUB];
+    for (i = 0; i < ix->n; i++) {
+        ckpt_put64(p, ix->ent[i].rec);
+        ckpt_put64(p + 8, ix->ent[i].coff);
+        ckpt_put64(p + 16, ix->ent[i].poff);
+        memcpy(p + 24, ix->ent[i].st, SBOB_SAVE);
+        p += CKPT_ENT;
+    }
+    p = &buf[CKPT_IHDR + CBYT_NPUB];
+    ckpt_init(&sb, key, &buf[CKPT_IHDR]);
+    sbob_seal(&sb, 0, buf, CKPT_IHDR, p, p, ix->n * CKPT_ENT,
+        p + ix->n * CKPT_ENT, CKPT_TAG);
+    memset(&sb, 0, sizeof(sb));
+
+    snprintf(side, sizeof(side), "%s.sbx", fn);
+    st = ckpt_write(side, buf, len);
+    free(buf);
+
+    return st;
+}
+
+// read the index of .sb1 file "fn", which has nonce "nnc". 0 if valid
+
+static int ckpt_idx_load(ckpt_idx_t *ix, const char *fn,
+    const uint8_t *key, const uint8_t nnc[CBYT_NPUB])
+{
+    int fs;
+    size_t i, len;
+    uint64_t n;
+    char side[CBYT_XFER];
+    uint8_t hdr[CKPT_IHDR], *buf, *p;
+    struct stat sst;
+    sbob_t sb;
+
+    memset(ix, 0, sizeof(ckpt_idx_t));
+    snprintf(side, sizeof(side), "%s.sbx", fn);
+    if ((fs = open(side, O_RDONLY)) == -1)
+        return CBERRNO;
+    if (fstat(fs, &sst) != 0 || sst.st_size < CKPT_IHDR ||
+        pread(fs, hdr, CKPT_IHDR, 0) != CKPT_IHDR ||
+        memcmp(hdr, "sbx1", 4) != 0 || memcmp(&hdr[16], nnc, CBYT_NPUB)) {
+        close(fs);
+        return CBERRNO;
+    }
+    ix->every = hdr[4] | (hdr[5] << 8) | (hdr[6] << 16) |
+        ((uint32_t) hdr[7] << 24);
+    n = ckpt_get64(&hdr[8]);
+    len = CKPT_IHDR + CBYT_NPUB + n * CKPT_ENT + CKPT_TAG;
+    if (ix->every == 0 || n == 0 || n > (uint64_t) sst.st_size ||
+        (uint64_t) sst.st_size != len || (buf = malloc(len)) == NULL) {
+        close(fs);
+        return CBERRNO;
+    }
+    i = pread(fs, buf, len, 0);
+    close(fs);
+
+    // open and check that the entries are in order from the start
+    p = &buf[CKPT_IHDR + CBYT_NPUB];
+    ckpt_init(&sb, key, &buf[CKPT_IHDR]);
+    if (i != len || sbob_open(&sb, 0, buf, CKPT_IHDR, p, p, n * CKPT_ENT,
+        p + n * CKPT_ENT, CKPT_TAG) != 0 ||
+        (ix->ent = malloc(n * sizeof(ckpt_ent_t))) == NULL) {
+        memset(&sb, 0, sizeof(sb));
+        free(buf);
+        return CBERRNO;
+    }
+    memset(&sb, 0, sizeof(sb));
+    ix->n = ix->cap = n;
+    for (i = 0; i < n; i++) {
+        ix->ent[i].rec = ckpt_get64(p);
+        ix->ent[i].coff = ckpt_get64(p + 8);
+        ix->ent[i].poff = ckpt_get64(p + 16);
+        memcpy(ix->ent[i].st, p + 24, SBOB_SAVE);
+        p += CKPT_ENT;
+        if (ix->ent[i].rec != i * ix->every || (i == 0 ?
+            ix->ent[0].coff != CBYT_NPUB || ix->ent[0].poff != 0 :
+            ix->ent[i].coff <= ix->ent[i - 1].coff ||
+            ix->ent[i].poff < ix->ent[i - 1].poff))
+            break;
+    }
+    memset(buf, 0, len);
+    free(buf);
+    if (i < n) {
+        ckpt_idx_free(ix);
+        return CBERRNO;
+    }
+
+    return 0;
+}
+
+// decrypt the records from ciphertext offset "coff" with the state in
+// wx->sbx, up to offset "end" or the final record if "end" is 0. the
+// plaintext in [off, off + len) is written to fdo, with pwrite() at
+// its own offset if "at". *poff is kept at the end of verified data
+
+static int ckpt_seg(stricat_t *wx, int fdi, int fdo, uint64_t coff,
+    uint64_t end, uint64_t *poff, uint64_t off, uint64_t len, int at)
+{
+    int n, st;
+    size_t cap;
+    uint64_t a, b, x;
+    uint8_t *buf, *p, ad[CBYT_LBUF + CBYT_HOLE];
+
+    // records longer than CBYT_XFER get a buffer of their own
+    buf = (uint8_t *) wx->xfr;
+    cap = CBYT_XFER;
+    st = CBERRNO;
+    while (end == 0 || coff < end) {
+        if (pread(fdi, wx->lbf, CBYT_LBUF, coff) != CBYT_LBUF)
+            break;
+        x = blnk_lbf_getl(wx);
+
+        // zero run: only the range output needs the zeros
+        if (x == BLNK_HOLE) {
+            if (pread(fdi, ad, sizeof(ad), coff) != sizeof(ad) ||
+                pread(fdi, wx->mac, CBYT_MAC, coff + sizeof(ad)) !=
+                CBYT_MAC || sbob_open(&wx->sbx, 0, ad, sizeof(ad),
+                NULL, NULL, 0, wx->mac, CBYT_MAC) != 0)
+                break;
+            for (x = 0, n = CBYT_HOLE - 1; n >= 0; n--)
+                x = (x << 8) | ad[CBYT_LBUF + n];
+            a = *poff > off ? *poff : off;
+            b = *poff + x < off + len ? *poff + x : off + len;
+            if (!at && a < b && ring_skip(fdo, b - a) != 0)
+                break;
+            coff += sizeof(ad) + CBYT_MAC;
+            *poff += x;
+            if (!at && *poff >= off + len) {
+                st = 0;
+                break;
+            }
+            continue;
+        }
+        if (x > CBYT_XMAX)
+            break;
+        n = x;
+        if ((size_t) n > cap) {
+            if ((p = malloc(n)) == NULL)
+                break;
+            if (buf != (uint8_t *) wx->xfr)
+                free(buf);
+            buf = p;
+            cap = n;
+        }
+        if (pread(fdi, buf, n, coff + CBYT_LBUF) != n ||
+            pread(fdi, wx->mac, CBYT_MAC, coff + CBYT_LBUF + n) != CBYT_MAC ||
+            sbob_open(&wx->sbx, 0, wx->lbf, CBYT_LBUF, buf, buf, n,
+            wx->mac, CBYT_MAC) != 0)
+            break;
+
+        // the part that is asked for
+        a = *poff > off ? *poff : off;
+        b = *poff + n < off + len ? *poff + n : off + len;
+        if (a < b && (at ? pwrite(fdo, buf + (a - *poff), b - a, a) :
+            write(fdo, buf + (a - *poff), b - a)) != (ssize_t) (b - a))
+            break;
+        coff += CBYT_LBUF + n + CBYT_MAC;
+        *poff += n;
+        if (n == 0 || (!at && *poff >= off + len)) {
+            st = 0;
+            break;
+        }
+    }
+    if (coff == end)
+        st = 0;
+
+    if (buf != (uint8_t *) wx->xfr) {
+        memset(buf, 0, cap);
+        free(buf);
+    }
+
+    return st;
+}
+
+// state for a worker: the file key and nonce, or an indexed one
+
+static int ckpt_start(stricat_t *wx, const ckpt_ent_t *e,
+    const uint8_t nnc[CBYT_NPUB])
+{
+    if (e != NULL)
+        return sbob_load(&wx->sbx, e->st);
+    sbob_clr(&wx->sbx);
+    sbob_put(&wx->sbx, BLNK_KEY, wx->key, CBYT_KEY);
+    sbob_fin(&wx->sbx, BLNK_KEY);
+    sbob_put(&wx->sbx, BLNK_NPUB, nnc, CBYT_NPUB);
+    sbob_fin(&wx->sbx, BLNK_NPUB);
+
+    return 0;
+}
+
+// parallel decryption; segment i runs from entry i to entry i + 1
+
+typedef struct {
+    const ckpt_idx_t *ix;
+    int fdi, fdo;
+    size_t next;
+    int stop;
+    uint64_t good;                          // verified plaintext
+    uint64_t tot;                           // plaintext length
+    pthread_mutex_t mtx;
+} ckpt_par_t;
+
+static void *ckpt_work(void *arg)
+{
+    int st;
+    size_t i;
+    uint64_t poff;
+    stricat_t *wx;
+    ckpt_par_t *pr = (ckpt_par_t *) arg;
+    const ckpt_idx_t *ix = pr->ix;
+
+    if ((wx = malloc(sizeof(stricat_t))) == NULL) {
+        pthread_mutex_lock(&pr->mtx);
+        pr->stop = 1;
+        pr->good = 0;
+        pthread_mutex_unlock(&pr->mtx);
+        return NULL;
+    }
+    memset(wx, 0x00, sizeof(stricat_t));
+
+    for (;;) {
+        pthread_mutex_lock(&pr->mtx);
+        if (pr->stop || pr->next >= ix->n) {
+            pthread_mutex_unlock(&pr->mtx);
+            break;
+        }
+        i = pr->next++;
+        pthread_mutex_unlock(&pr->mtx);
+
+        poff = ix->ent[i].poff;
+        st = ckpt_start(wx, &ix->ent[i], NULL);
+        if (st == 0)
+            st = ckpt_seg(wx, pr->fdi, pr->fdo, ix->ent[i].coff,
+                i + 1 < ix->n ? ix->ent[i + 1].coff : 0, &poff,
+                0, ~0llu, 1);
+        if (st == 0 && i + 1 < ix->n && poff != ix->ent[i + 1].poff)
+            st = CBERRNO;
+
+        pthread_mutex_lock(&pr->mtx);
+        if (st != 0) {
+            pr->stop = 1;
+            if (poff < pr->good)
+                pr->good = poff;
+        } else if (i + 1 == ix->n) {
+            pr->tot = poff;
+        }
+        pthread_mutex_unlock(&pr->mtx);
+    }
+
+    memset(wx, 0x00, sizeof(stricat_t));
+    free(wx);
+
+    return NULL;
+}
+
+// decrypt a file with its index
+
+int ckpt_dec_file(stricat_t *cx, const char *fn, int threads)
+{
+    int fdi, fdo, len, st;
+    size_t k, i;
+    char out[CBYT_XFER];
+    uint8_t nnc[CBYT_NPUB];
+    pthread_t *tid;
+    ckpt_idx_t ix;
+    ckpt_par_t pr;
+
+    // without a valid index this is the usual sequential decryption
+    memset(&ix, 0, sizeof(ix));
+    len = strlen(fn);
+    if (threads < 2 || len <= 4 || strcmp(&fn[len - 4], ".sb1") != 0 ||
+        (fdi = open(fn, O_RDONLY)) == -1)
+        return iocom_dec_file(cx, fn);
+    if (pread(fdi, nnc, CBYT_NPUB, 0) != CBYT_NPUB ||
+        ckpt_idx_load(&ix, fn, cx->key, nnc) != 0 || ix.n < 2) {
+        if (ix.n > 0)
+            ckpt_idx_free(&ix);
+        close(fdi);
+        return iocom_dec_file(cx, fn);
+    }
+
+    snprintf(out, sizeof(out), "%.*s", len - 4, fn);
+    if ((fdo = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0664)) == -1) {
+        perror(out);
+        close(fdi);
+        ckpt_idx_free(&ix);
+        return 1;
+    }
+    if ((tid = malloc(threads * sizeof(pthread_t))) == NULL) {
+        close(fdo);
+        close(fdi);
+        ckpt_idx_free(&ix);
+        return CBERRNO;
+    }
+
+    memset(&pr, 0, sizeof(pr));
+    pr.ix = &ix;
+    pr.fdi = fdi;
+    pr.fdo = fdo;
+    pr.good = ~0llu;
+    pthread_mutex_init(&pr.mtx, NULL);
+    for (k = 0; k < (size_t) threads && k < ix.n; k++) {
+        if (pthread_create(&tid[k], NULL, ckpt_work, &pr) != 0)
+            break;
+    }
+    if (k == 0)
+        ckpt_work(&pr);
+    for (i = 0; i < k; i++)
+        pthread_join(tid[i], NULL);
+    pthread_mutex_destroy(&pr.mtx);
+
+    // keep what was verified, in order
+    st = 0;
+    if (pr.stop) {
+        fprintf(stderr, "ckpt_dec: chunk integrity error!\n");
+        if (ftruncate(fdo, pr.good) != 0)
+            perror(out);
+        st = CBERRNO;
+    } else if (ftruncate(fdo, pr.tot) != 0) {
+        perror(out);
+        st = CBERRNO;
+    }
+
+    free(tid);
+    close(fdo);
+    close(fdi);
+    ckpt_idx_free(&ix);
+
+    return st;
+}
+
+// decrypt a range
+
+int ckpt_range(stricat_t *cx, const char *fn, uint64_t off, uint64_t len)
+{
+    int fd, st;
+    size_t a, b, m;
+    uint64_t poff;
+    uint8_t nnc[CBYT_NPUB];
+    ckpt_ent_t *e;
+    ckpt_idx_t ix;
+
+    if (len > ~0llu - off)
+        len = ~0llu - off;
+    if ((fd = open(fn, O_RDONLY)) == -1) {
+        perror(fn);
+        return 1;
+    }
+    if (pread(fd, nnc, CBYT_NPUB, 0) != CBYT_NPUB) {
+        fprintf(stderr, "%s: not a .sb1 file.\n", fn);
+        close(fd);
+        return CBERRNO;
+    }
+
+    // the last entry at or before the offset; from the start if none
+    e = NULL;
+    if (ckpt_idx_load(&ix, fn, cx->key, nnc) == 0) {
+        a = 0;
+        b = ix.n;
+        while (b - a > 1) {
+            m = (a + b) / 2;
+            if (ix.ent[m].poff <= off)
+                a = m;
+            else
+                b = m;
+        }
+        e = &ix.ent[a];
+    }
+
+    poff = e != NULL ? e->poff : 0;
+    st = ckpt_start(cx, e, nnc);
+    if (st == 0 && len > 0)
+        st = ckpt_seg(cx, fd, cx->fdo, e != NULL ? e->coff : CBYT_NPUB, 0,
+            &poff, off, len, 0);
+    if (st != 0)
+        fprintf(stderr, "%s: chunk integrity error!\n", fn);
+
+    if (e != NULL)
+        ckpt_idx_free(&ix);
+    close(fd);
+
+    return st;
+}
@@ -0,0 +1,53 @@
+// ckpt.h
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+#ifndef CKPT_H
+#define CKPT_H
+
+#include "blnk.h"
+
+// fingerprint of the hashed prefix; its length and the bytes read from
+// each end of the prefix to compute it
+#define CKPT_FP 16
+#define CKPT_EDGE 4096
+
+// hash file "fn" with mode 's' (STRIBOB, keyed with cx->key if "keyed")
+// or 'g' / 'G' (Streebog 256 / 512), resuming from its sidecar file if
+// that matches, and save the new state there. digest left in cx->xfr;
+// failing to write the sidecar is reported but not an error
+int ckpt_hash(stricat_t *cx, const char *fn, int mode, int keyed);
+
+// decryption index of a .sb1 file, kept in FILE.sb1.sbx: the sponge
+// state before every "every"th record and the offsets of that record
+typedef struct {
+    uint64_t rec;                           // record number
+    uint64_t coff, poff;                    // ciphertext, plaintext offset
+    uint8_t st[SBOB_SAVE];                  // state before the record
+} ckpt_ent_t;
+
+typedef struct {
+    uint32_t every;                         // 0 = no index
+    size_t n, cap;
+    ckpt_ent_t *ent;
+} ckpt_idx_t;
+
+// while encrypting: called before each record, adds every "every"th
+void ckpt_idx_add(ckpt_idx_t *ix, const sbob_t *sb, uint64_t rec,
+    uint64_t coff, uint64_t poff);
+
+// seal the index of .sb1 file "fn" (nonce "nnc") into its sidecar
+int ckpt_idx_save(ckpt_idx_t *ix, const char *fn, const uint8_t *key,
+    const uint8_t nnc[CBYT_NPUB]);
+
+void ckpt_idx_free(ckpt_idx_t *ix);
+
+// decrypt .sb1 file "fn" with "threads" threads starting at the indexed
+// states; the same as iocom_dec_file() if there's no valid index
+int ckpt_dec_file(stricat_t *cx, const char *fn, int threads);
+
+// decrypt "len" bytes at offset "off" of .sb1 file "fn" to cx->fdo,
+// starting from the closest indexed state
+int ckpt_range(stricat_t *cx, const char *fn, uint64_t off, uint64_t len);
+
+#endif
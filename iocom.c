@@ -2,28 +2,434 @@
 // 08-Dec-13    Markku-Juhani O. Saarinen <mjos@cblnk.com>
 //              See LICENSE for Licensing and Warranty information.
 
+#define _GNU_SOURCE
 #include "blnk.h"
 #include "iocom.h"
+#include "ring.h"
+#include "ckpt.h"
+#include <sys/mman.h>
+
+// Regular files are mapped into memory and processed from there; other
+// inputs (and outputs) go through read() and write() in ring.c
+
+// map a regular input file. NULL if it can't be; "pos" is the current
+// file offset, which must be restored with iocom_unmap()
+
+static uint8_t *iocom_map(int fd, size_t *mlen, size_t *pos)
+{
+    off_t off;
+    void *p;
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (uint64_t) st.st_size > (size_t) -1 ||
+        (off = lseek(fd, 0, SEEK_CUR)) < 0 || off > st.st_size)
+        return NULL;
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    *mlen = st.st_size;
+    *pos = off;
+
+    return (uint8_t *) p;
+}
+
+// map a new, empty output file of "len" bytes. NULL if it can't be
+
+static uint8_t *iocom_map_out(int fd, size_t len)
+{
+    int fl;
+    void *p;
+    struct stat st;
+
+    if (len == 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        st.st_size != 0 || lseek(fd, 0, SEEK_CUR) != 0 ||
+        (fl = fcntl(fd, F_GETFL)) == -1 || (fl & O_APPEND) ||
+        (fl & O_ACCMODE) != O_RDWR)
+        return NULL;
+    if (posix_fallocate(fd, 0, len) != 0 || (p = mmap(NULL, len,
+        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        if (ftruncate(fd, 0) != 0)
+            perror("iocom_map_out");
+        return NULL;
+    }
+    madvise(p, len, MADV_SEQUENTIAL);
+
+    return (uint8_t *) p;
+}
+
+// unmap and leave the file offset at "pos"
+
+static void iocom_unmap(int fd, uint8_t *p, size_t mlen, size_t pos)
+{
+    munmap(p, mlen);
+    lseek(fd, pos, SEEK_SET);
+}
 
 // input (hash) a bulk file
 
 int iocom_hash(stricat_t *cx)
 {
-    int len;
+    size_t mlen, pos;
+    uint8_t *map;
+    ring_t rg;
+    ring_slot_t *sl;
+
+    if ((map = iocom_map(cx->fdi, &mlen, &pos)) != NULL) {
+        sbob_put(&cx->sbx, BLNK_DAT, map + pos, mlen - pos);
+        sbob_fin(&cx->sbx, BLNK_DAT);
+        iocom_unmap(cx->fdi, map, mlen, mlen);
+        return 0;
+    }
 
-    while ((len = read(cx->fdi, cx->xfr, CBYT_XFER)) > 0) {
-        sbob_put(&cx->sbx, BLNK_DAT, cx->xfr, len);
+    if (ring_start(&rg, cx->fdi, -1, RING_RAW, CBYT_XFER) != 0)
+        return CBERRNO;
+    while ((sl = ring_next(&rg)) != NULL && sl->len > 0) {
+        sbob_put(&cx->sbx, BLNK_DAT, sl->buf, sl->len);
+        ring_done(&rg);
     }
     sbob_fin(&cx->sbx, BLNK_DAT);
 
-    return 0;
+    return ring_stop(&rg) != 0 || sl == NULL || sl->len < 0 ? CBERRNO : 0;
 }
 
-// encrypt an io stream
+// the same with Streebog
 
-int iocom_enc(stricat_t *cx)
+int iocom_streebog(stricat_t *cx, streebog_t *sbog)
+{
+    size_t mlen, pos;
+    uint8_t *map;
+    ring_t rg;
+    ring_slot_t *sl;
+
+    if ((map = iocom_map(cx->fdi, &mlen, &pos)) != NULL) {
+        streebog_update(sbog, map + pos, mlen - pos);
+        iocom_unmap(cx->fdi, map, mlen, mlen);
+        return 0;
+    }
+
+    if (ring_start(&rg, cx->fdi, -1, RING_RAW, CBYT_XFER) != 0)
+        return CBERRNO;
+    while ((sl = ring_next(&rg)) != NULL && sl->len > 0) {
+        streebog_update(sbog, sl->buf, sl->len);
+        ring_done(&rg);
+    }
+
+    return ring_stop(&rg) != 0 || sl == NULL || sl->len < 0 ? CBERRNO : 0;
+}
+
+// several digests of one input, each on its own thread. a mapped file
+// is shared as it is; other input is read once into IOCOM_MSLOT
+// buffers, each of which is reused after every digest has taken it
+
+#define IOCOM_MSLOT 8
+
+typedef struct {
+    uint8_t *buf;
+    ssize_t len[IOCOM_MSLOT];
+    int ref[IOCOM_MSLOT];                   // digests still to take it
+    uint64_t head;                          // buffers filled
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+} iocom_mbuf_t;
+
+typedef struct {
+    int op;                                 // 's', 'g' or 'G'
+    sbob_t sbx;
+    streebog_t sbog;
+    const uint8_t *map;                     // mapped input, or
+    size_t mlen;
+    iocom_mbuf_t *mb;                       // the shared buffers
+    int st;
+} iocom_mdig_t;
+
+static void iocom_mput(iocom_mdig_t *dg, const uint8_t *p, size_t len)
+{
+    if (dg->op == 's')
+        sbob_put(&dg->sbx, BLNK_DAT, p, len);
+    else
+        streebog_update(&dg->sbog, p, len);
+}
+
+static void *iocom_mwork(void *arg)
 {
-    int len;
+    int i;
+    ssize_t len;
+    uint64_t seq;
+    iocom_mdig_t *dg = (iocom_mdig_t *) arg;
+    iocom_mbuf_t *mb = dg->mb;
+
+    if (mb == NULL) {
+        iocom_mput(dg, dg->map, dg->mlen);
+        return NULL;
+    }
+
+    for (seq = 0;; seq++) {
+        i = seq % IOCOM_MSLOT;
+        pthread_mutex_lock(&mb->mtx);
+        while (seq >= mb->head)
+            pthread_cond_wait(&mb->cv, &mb->mtx);
+        len = mb->len[i];
+        pthread_mutex_unlock(&mb->mtx);
+
+        if (len > 0)
+            iocom_mput(dg, mb->buf + i * CBYT_XFER, len);
+
+        pthread_mutex_lock(&mb->mtx);
+        if (--mb->ref[i] == 0)
+            pthread_cond_broadcast(&mb->cv);
+        pthread_mutex_unlock(&mb->mtx);
+        if (len <= 0)
+            break;
+    }
+    if (len < 0)
+        dg->st = CBERRNO;
+
+    return NULL;
+}
+
+int iocom_multi(stricat_t *cx, int keyed, const char *ops)
+{
+    int i, k, n, st;
+    ssize_t len;
+    size_t mlen, pos;
+    uint64_t seq;
+    uint8_t *map, *md;
+    pthread_t tid[3];
+    iocom_mdig_t dg[3];
+    iocom_mbuf_t mb;
+
+    if ((n = strlen(ops)) < 1 || n > 3)
+        return CBERRNO;
+    memset(dg, 0, sizeof(dg));
+    for (i = 0; i < n; i++) {
+        dg[i].op = ops[i];
+        if (ops[i] == 's') {
+            sbob_clr(&dg[i].sbx);
+            if (keyed) {
+                sbob_put(&dg[i].sbx, BLNK_KEY, cx->key, CBYT_KEY);
+                sbob_fin(&dg[i].sbx, BLNK_KEY);
+            }
+        } else {
+            streebog_init(&dg[i].sbog, ops[i] == 'g' ? 32 : 64);
+        }
+    }
+
+    memset(&mb, 0, sizeof(mb));
+    if ((map = iocom_map(cx->fdi, &mlen, &pos)) != NULL) {
+        for (i = 0; i < n; i++) {
+            dg[i].map = map + pos;
+            dg[i].mlen = mlen - pos;
+        }
+    } else {
+        if ((mb.buf = malloc(IOCOM_MSLOT * CBYT_XFER)) == NULL)
+            return CBERRNO;
+        pthread_mutex_init(&mb.mtx, NULL);
+        pthread_cond_init(&mb.cv, NULL);
+        for (i = 0; i < n; i++)
+            dg[i].mb = &mb;
+    }
+
+    for (k = 0; k < n; k++) {
+        if (pthread_create(&tid[k], NULL, iocom_mwork, &dg[k]) != 0)
+            break;
+    }
+    st = k < n ? CBERRNO : 0;
+
+    // read; the ones that didn't start get an immediate end of file
+    if (map == NULL) {
+        for (seq = 0;; seq++) {
+            i = seq % IOCOM_MSLOT;
+            pthread_mutex_lock(&mb.mtx);
+            while (mb.ref[i] > 0)
+                pthread_cond_wait(&mb.cv, &mb.mtx);
+            pthread_mutex_unlock(&mb.mtx);
+
+            len = 0;
+            if (st == 0) {
+                while ((len = read(cx->fdi, mb.buf + i * CBYT_XFER,
+                    CBYT_XFER)) < 0 && errno == EINTR)
+                    ;
+            }
+
+            pthread_mutex_lock(&mb.mtx);
+            mb.len[i] = len;
+            mb.ref[i] = k;
+            mb.head++;
+            pthread_cond_broadcast(&mb.cv);
+            pthread_mutex_unlock(&mb.mtx);
+            if (len <= 0)
+                break;
+        }
+    }
+
+    for (i = 0; i < k; i++) {
+        pthread_join(tid[i], NULL);
+        if (dg[i].st != 0)
+            st = dg[i].st;
+    }
+
+    if (map != NULL) {
+        iocom_unmap(cx->fdi, map, mlen, mlen);
+    } else {
+        pthread_cond_destroy(&mb.cv);
+        pthread_mutex_destroy(&mb.mtx);
+        free(mb.buf);
+    }
+
+    // digests one after another
+    md = (uint8_t *) cx->xfr;
+    for (i = 0; i < n && st == 0; i++) {
+        if (dg[i].op == 's') {
+            sbob_fin(&dg[i].sbx, BLNK_DAT);
+            sbob_get(&dg[i].sbx, BLNK_HASH, md, CBYT_HASH);
+            md += CBYT_HASH;
+        } else {
+            streebog_final(md, &dg[i].sbog);
+            md += dg[i].op == 'g' ? 32 : 64;
+        }
+    }
+    memset(dg, 0, sizeof(dg));
+
+    return st;
+}
+
+// the data at or after "i" in the mapped file, which starts at offset
+// "base" in fd. *dend is set to where that data ends (the next hole)
+
+static size_t iocom_data(int fd, size_t base, size_t i, size_t len,
+    size_t *dend)
+{
+    off_t d, h;
+
+    *dend = len;
+    if ((d = lseek(fd, base + i, SEEK_DATA)) < 0)
+        return errno == ENXIO ? len : i;    // all hole, or no support
+    if ((size_t) d >= base + len)
+        return len;
+    if ((h = lseek(fd, d, SEEK_HOLE)) >= 0 && (size_t) h < base + len)
+        *dend = h - base;
+
+    return d - base;
+}
+
+// seal and write a zero-run record of "len" bytes
+
+static int iocom_hole(stricat_t *cx, uint64_t len)
+{
+    uint8_t ad[CBYT_LBUF + CBYT_HOLE];
+    struct iovec iov[2];
+
+    blnk_hole_ad(ad, len);
+    sbob_seal(&cx->sbx, 0, ad, sizeof(ad), NULL, NULL, 0,
+        cx->mac, CBYT_MAC);
+    iov[0].iov_base = ad;
+    iov[0].iov_len = sizeof(ad);
+    iov[1].iov_base = cx->mac;
+    iov[1].iov_len = CBYT_MAC;
+
+    return ring_writev(cx->fdo, iov, 2);
+}
+
+// encrypt from a mapped input, into a mapped output if possible, in
+// records of "cs" bytes. With cx->hole, the holes of the file (mapped
+// from offset "base") become zero-run records. At the default size the
+// data records are cut exactly where read() would cut a regular file.
+
+static int iocom_enc_map(stricat_t *cx, const uint8_t *in, size_t len,
+    size_t base, size_t cs, ckpt_idx_t *ix)
+{
+    int n, st;
+    uint64_t rec, coff;
+    size_t i, d, dend, olen;
+    uint8_t *out, *q, *buf;
+    struct iovec iov[3];
+
+    olen = CBYT_NPUB + len + (len / cs + (len % cs != 0) + 1) *
+        (CBYT_LBUF + CBYT_MAC);
+    buf = NULL;
+    out = cx->hole ? NULL : iocom_map_out(cx->fdo, olen);
+    if (out != NULL) {
+        memcpy(out, cx->nnc, CBYT_NPUB);
+    } else if (write(cx->fdo, cx->nnc, CBYT_NPUB) != CBYT_NPUB) {
+        perror("iocom_enc: error writing nonce");
+        return CBERRNO;
+    } else if ((buf = cs > CBYT_XFER ? malloc(cs) :
+        (uint8_t *) cx->xfr) == NULL) {
+        return CBERRNO;
+    }
+    q = out != NULL ? out + CBYT_NPUB : NULL;
+
+    // an empty record ends the stream
+    st = 0;
+    i = 0;
+    rec = 0;
+    coff = CBYT_NPUB;
+    dend = cx->hole ? 0 : len;
+    do {
+        // skip to the next data
+        if (i >= dend && i < len && (d = iocom_data(cx->fdi, base, i, len,
+            &dend)) > i) {
+            ckpt_idx_add(ix, &cx->sbx, rec++, coff, i);
+            if (iocom_hole(cx, d - i) != 0) {
+                perror("iocom_enc: error writing zero run");
+                st = CBERRNO;
+                break;
+            }
+            coff += CBYT_LBUF + CBYT_HOLE + CBYT_MAC;
+            i = d;
+            n = 1;
+            continue;
+        }
+
+        n = len - i < cs ? len - i : cs;
+        if (n > dend - i && dend > i)
+            n = dend - i;
+        ckpt_idx_add(ix, &cx->sbx, rec++, coff, i);
+        coff += CBYT_LBUF + n + CBYT_MAC;
+        blnk_lbf_putl(cx, n);
+        if (out != NULL) {
+            memcpy(q, cx->lbf, CBYT_LBUF);
+            sbob_seal(&cx->sbx, 0, cx->lbf, CBYT_LBUF, q + CBYT_LBUF,
+                in + i, n, q + CBYT_LBUF + n, CBYT_MAC);
+            q += CBYT_LBUF + n + CBYT_MAC;
+        } else {
+            sbob_seal(&cx->sbx, 0, cx->lbf, CBYT_LBUF, buf,
+                in + i, n, cx->mac, CBYT_MAC);
+            iov[0].iov_base = cx->lbf;
+            iov[0].iov_len = CBYT_LBUF;
+            iov[1].iov_base = buf;
+            iov[1].iov_len = n;
+            iov[2].iov_base = cx->mac;
+            iov[2].iov_len = CBYT_MAC;
+            if (ring_writev(cx->fdo, iov, 3) != 0) {
+                perror("iocom_enc: error writing chunk");
+                st = CBERRNO;
+                break;
+            }
+        }
+        i += n;
+    } while (n > 0);
+
+    if (out != NULL)
+        iocom_unmap(cx->fdo, out, olen, olen);
+    if (buf != NULL && buf != (uint8_t *) cx->xfr)
+        free(buf);
+
+    return st;
+}
+
+// encrypt an io stream, indexing it into "ix" unless that is NULL
+
+static int iocom_enc_ix(stricat_t *cx, ckpt_idx_t *ix)
+{
+    int len, st;
+    uint64_t rec, coff, poff;
+    size_t cs, mlen, pos;
+    uint8_t *map;
+    ring_t rg;
+    ring_slot_t *sl;
 
     // init the state with key and nonce
     sbob_clr(&cx->sbx);
@@ -34,54 +440,173 @@ int iocom_enc(stricat_t *cx)
     sbob_put(&cx->sbx, BLNK_NPUB, cx->nnc, CBYT_NPUB);
     sbob_fin(&cx->sbx, BLNK_NPUB);
 
+    // records of cx->blk bytes, or as read() returns them
+    cs = cx->blk != 0 ? cx->blk : CBYT_XFER;
+
+    // regular file
+    if ((map = iocom_map(cx->fdi, &mlen, &pos)) != NULL) {
+        st = iocom_enc_map(cx, map + pos, mlen - pos, pos, cs, ix);
+        iocom_unmap(cx->fdi, map, mlen, mlen);
+        return st;
+    }
+
     if (write(cx->fdo, cx->nnc, CBYT_NPUB) != CBYT_NPUB) {
         perror("iocom_enc: error writing nonce");
         return CBERRNO;
     }
 
-    // run the data
-    while (1) {
+    // run the data; an empty record ends the stream
+    if (ring_start(&rg, cx->fdi, cx->fdo, RING_RAW | RING_WREC |
+        (cx->blk != 0 ? RING_FULL : 0), cs) != 0)
+        return CBERRNO;
+    rec = 0;
+    coff = CBYT_NPUB;
+    poff = 0;
+    while ((sl = ring_next(&rg)) != NULL && sl->len >= 0) {
+        len = sl->len;
+        ckpt_idx_add(ix, &cx->sbx, rec++, coff, poff);
+        coff += CBYT_LBUF + len + CBYT_MAC;
+        poff += len;
+        blnk_lbf_putl(cx, len);
+        memcpy(sl->lbf, cx->lbf, CBYT_LBUF);
+        sbob_seal(&cx->sbx, 0, sl->lbf, CBYT_LBUF,
+            sl->buf, sl->buf, len, sl->mac, CBYT_MAC);
+        ring_done(&rg);
+        if (len == 0)
+            break;
+    }
 
-        len = read(cx->fdi, cx->xfr, CBYT_XFER);
-        blnk_lbf_putl(cx, len, 0);
-        if (write(cx->fdo, cx->lbf, CBYT_LBUF) != CBYT_LBUF) {
-            perror("iocom_enc: error writing chunk length");
-            return CBERRNO;
+    return ring_stop(&rg) != 0 || sl == NULL || sl->len < 0 ? CBERRNO : 0;
+}
+
+int iocom_enc(stricat_t *cx)
+{
+    return iocom_enc_ix(cx, NULL);
+}
+
+// decrypt from a mapped input, into a mapped output if possible. "*end"
+// is set to the end of the records. 1 if the records are not intact,
+// so that the stream code can report it
+
+static int iocom_dec_map(stricat_t *cx, const uint8_t *in, size_t len,
+    size_t *end)
+{
+    int j, n, mx, st, hole;
+    size_t i, o, olen;
+    uint64_t x;
+    uint8_t *out, *buf;
+    struct iovec iov;
+
+    // find the records, the plaintext length and the longest record
+    olen = 0;
+    mx = 0;
+    hole = 0;
+    for (i = 0; ; i += CBYT_LBUF + n + CBYT_MAC) {
+        if (len - i < CBYT_LBUF)
+            return 1;
+        memcpy(cx->lbf, in + i, CBYT_LBUF);
+        x = blnk_lbf_getl(cx);
+        n = x == BLNK_HOLE ? CBYT_HOLE : (int) x;
+        if ((x != BLNK_HOLE && x > CBYT_XMAX) ||
+            len - i - CBYT_LBUF < (size_t) n + CBYT_MAC)
+            return 1;
+        if (x == BLNK_HOLE) {
+            hole = 1;
+            continue;
         }
-        if (len <= 0)
+        olen += n;
+        if (n > mx)
+            mx = n;
+        if (n == 0)
             break;
+    }
+    *end = i + CBYT_LBUF + CBYT_MAC;
 
-        sbob_enc(&cx->sbx, BLNK_MSG, cx->xfr, cx->xfr, len);
-        sbob_fin(&cx->sbx, BLNK_MSG);
-        if (write(cx->fdo, cx->xfr, len) != len) {
-            perror("iocom_enc: error writing chunk");
-            return CBERRNO;
+    // zero runs are written as holes, not into a mapped file
+    buf = NULL;
+    out = hole ? NULL : iocom_map_out(cx->fdo, olen);
+    if (out == NULL &&
+        (buf = mx > CBYT_XFER ? malloc(mx) : (uint8_t *) cx->xfr) == NULL)
+        return CBERRNO;
+    st = 0;
+    o = 0;
+    for (i = 0; ; i += CBYT_LBUF + n + CBYT_MAC) {
+        memcpy(cx->lbf, in + i, CBYT_LBUF);
+        x = blnk_lbf_getl(cx);
+
+        // the run length is authenticated with the marker as AAD
+        if (x == BLNK_HOLE) {
+            n = CBYT_HOLE;
+            for (x = 0, j = CBYT_HOLE - 1; j >= 0; j--)
+                x = (x << 8) | in[i + CBYT_LBUF + j];
+            if (sbob_open(&cx->sbx, 0, in + i, CBYT_LBUF + CBYT_HOLE,
+                NULL, NULL, 0, in + i + CBYT_LBUF + CBYT_HOLE,
+                CBYT_MAC) != 0) {
+                fprintf(stderr, "iocom_dec: chunk integrity error!\n");
+                st = CBERRNO;
+                break;
+            }
+            if (ring_skip(cx->fdo, x) != 0) {
+                perror("iocom_dec: plaintext write error");
+                st = CBERRNO;
+                break;
+            }
+            o += x;
+            continue;
+        }
+        n = x;
+
+        // decrypt and compare mac; n == 0 is the final block
+        if (sbob_open(&cx->sbx, 0, cx->lbf, CBYT_LBUF,
+            out != NULL ? out + o : buf, in + i + CBYT_LBUF,
+            n, in + i + CBYT_LBUF + n, CBYT_MAC) != 0) {
+            if (n > 0)
+                fprintf(stderr, "iocom_dec: chunk integrity error!\n");
+            else
+                fprintf(stderr, "iocom_dec: final integrity error!\n");
+            if (out != NULL) {              // keep what was verified
+                munmap(out, olen);
+                out = NULL;
+                if (ftruncate(cx->fdo, o) == 0)
+                    lseek(cx->fdo, o, SEEK_SET);
+            }
+            st = CBERRNO;
+            break;
         }
+        if (n == 0)
+            break;
 
-        sbob_get(&cx->sbx, BLNK_MAC, cx->mac, CBYT_MAC);
-        sbob_fin(&cx->sbx, BLNK_MAC);
-        if (write(cx->fdo, cx->mac, CBYT_MAC) != CBYT_MAC) {
-            perror("iocom_enc: error writing MAC");
-            return CBERRNO;
+        // we may now write the plaintext
+        if (out == NULL) {
+            iov.iov_base = buf;
+            iov.iov_len = n;
+            if (ring_writev(cx->fdo, &iov, 1) != 0) {
+                perror("iocom_dec: plaintext write error");
+                st = CBERRNO;
+                break;
+            }
         }
+        o += n;
     }
 
-    // extract the final mac
-    sbob_get(&cx->sbx, BLNK_MAC, cx->mac, CBYT_MAC);
-    sbob_fin(&cx->sbx, BLNK_MAC);
-    if (write(cx->fdo, cx->mac, CBYT_MAC) != CBYT_MAC) {
-        perror("iocom_enc: error writing final MAC");
-        return CBERRNO;
-    }
+    if (out != NULL)
+        iocom_unmap(cx->fdo, out, olen, olen);
+    if (buf != NULL && buf != (uint8_t *) cx->xfr)
+        free(buf);
 
-    return 0;
+    return st;
 }
 
 // decrypt an io stream
 
 int iocom_dec(stricat_t *cx)
 {
-    int len;
+    int len, n;
+    uint8_t ad[CBYT_LBUF + CBYT_HOLE];
+    size_t mlen, pos, end;
+    uint8_t *map;
+    ring_t rg;
+    ring_slot_t *sl;
     struct stat st;
 
     // init the state with key and nonce
@@ -89,66 +614,65 @@ int iocom_dec(stricat_t *cx)
     sbob_put(&cx->sbx, BLNK_KEY, cx->key, CBYT_KEY);
     sbob_fin(&cx->sbx, BLNK_KEY);
 
-    if (read(cx->fdi, cx->nnc, CBYT_NPUB) != CBYT_NPUB) {
-        perror("iocom_dec: error reading nonce");
-        return CBERRNO;
+    for (len = 0; len < CBYT_NPUB; len += n) {
+        if ((n = read(cx->fdi, cx->nnc + len, CBYT_NPUB - len)) <= 0) {
+            if (n < 0 && errno == EINTR) {
+                n = 0;
+                continue;
+            }
+            perror("iocom_dec: error reading nonce");
+            return CBERRNO;
+        }
     }
     sbob_put(&cx->sbx, BLNK_NPUB, cx->nnc, CBYT_NPUB);
     sbob_fin(&cx->sbx, BLNK_NPUB);
 
-    while (1) {
-        if (read(cx->fdi, cx->lbf, CBYT_LBUF) != CBYT_LBUF) {
-            perror("iocom_dec: error reading chunk size");
-            return CBERRNO;
-        }
-        len = blnk_lbf_getl(cx, 0);
-
-        if (len < 0 || len > CBYT_XFER) {
-            fprintf(stderr, "iocom_dec: chunk format / integrity error.\n");
-            return 3;
-        }
-        if (len == 0) {          // that was the final block
-            break;
-        }
-           
-        if (read(cx->fdi, cx->xfr, len) != len) {
-            perror("iocom_dec: error reading encrypted chunk");
-            return CBERRNO;
-        }
-
-        // decrypt and compare mac
-        sbob_dec(&cx->sbx, BLNK_MSG, cx->xfr, cx->xfr, len);
-        sbob_fin(&cx->sbx, BLNK_MSG);
+    // regular file with intact records
+    if ((map = iocom_map(cx->fdi, &mlen, &pos)) != NULL) {
+        len = iocom_dec_map(cx, map + pos, mlen - pos, &end);
+        iocom_unmap(cx->fdi, map, mlen, len == 1 ? pos : pos + end);
+        if (len < 0)
+            return len;
+        if (len == 0)
+            goto trailer;
+    }
 
-        if (read(cx->fdi, cx->mac, CBYT_MAC) != CBYT_MAC) {
-            perror("iocom_dec: error reading MAC");
-            return CBERRNO;
+    // records are read and plaintext written by the ring threads
+    if (ring_start(&rg, cx->fdi, cx->fdo, RING_REC | RING_WRAW,
+        CBYT_XFER) != 0)
+        return CBERRNO;
+    while ((sl = ring_next(&rg)) != NULL && sl->len >= 0) {
+
+        // decrypt and compare mac; len == 0 is the final block
+        len = sl->len;
+        if (sl->hole != 0) {
+            blnk_hole_ad(ad, sl->hole);
+            n = sbob_open(&cx->sbx, 0, ad, sizeof(ad), NULL, NULL, 0,
+                sl->mac, CBYT_MAC);
+            len = 1;
+        } else {
+            n = sbob_open(&cx->sbx, 0, sl->lbf, CBYT_LBUF,
+                sl->buf, sl->buf, len, sl->mac, CBYT_MAC);
         }
-        if (sbob_cmp(&cx->sbx, BLNK_MAC, cx->mac, CBYT_MAC) != 0) {
-            fprintf(stderr, "iocom_dec: chunk integrity error!\n");
+        if (n != 0) {
+            if (len > 0)
+                fprintf(stderr, "iocom_dec: chunk integrity error!\n");
+            else
+                fprintf(stderr, "iocom_dec: final integrity error!\n");
+            ring_stop(&rg);
             return CBERRNO;
         }
-        sbob_fin(&cx->sbx, BLNK_MAC);
 
         // we may now write the plaintext
-        if (write(cx->fdo, cx->xfr, len) != len) {
-            perror("iocom_dec: plaintext write error");
-            return CBERRNO;
-        }
-    }
-
-    // final mac
-    if (read(cx->fdi, cx->mac, CBYT_MAC) != CBYT_MAC) {
-        perror("iocom_dec: error reading final MAC");
-        return CBERRNO;
+        ring_done(&rg);
+        if (len == 0)
+            break;
     }
-    if (sbob_cmp(&cx->sbx, BLNK_MAC, cx->mac, CBYT_MAC) != 0) {
-        fprintf(stderr, "iocom_dec: final integrity error!\n");
+    if (ring_stop(&rg) != 0 || sl == NULL || sl->len < 0)
         return CBERRNO;
-    }
-    sbob_fin(&cx->sbx, BLNK_MAC);
-    
+
     // check if there's garbage at the end
+trailer:
     if (fstat(cx->fdi, &st) != 0)
         return 0;
         
@@ -164,6 +688,133 @@ int iocom_dec(stricat_t *cx)
     return 0;
 }
 
+// encrypt file "fn" into "fn.sb1", with an index of every "every"th
+// record unless it is 0. 1 if the files can't be opened
+
+int iocom_enc_file(stricat_t *cx, const char *fn, int every)
+{
+    int st;
+    ckpt_idx_t ix;
+
+    if ((cx->fdi = open(fn, O_RDONLY)) == -1) {
+        perror(fn);
+        cx->fdi = STDIN_FILENO;
+        return 1;
+    }
+    snprintf(cx->xfr, CBYT_XFER, "%s.sb1", fn);
+    // read-write so that the output can be mapped
+    if ((cx->fdo =
+        open(cx->xfr, O_RDWR | O_CREAT | O_TRUNC, 0664)) == -1) {
+        perror(cx->xfr);
+        cx->fdo = STDOUT_FILENO;
+        close(cx->fdi);
+        cx->fdi = STDIN_FILENO;
+        return 1;
+    }
+
+    memset(&ix, 0, sizeof(ix));
+    ix.every = every;
+    st = iocom_enc_ix(cx, every > 0 ? &ix : NULL);
+    snprintf(cx->xfr, CBYT_XFER, "%s.sb1", fn);
+    if (st == 0 && every > 0 &&
+        ckpt_idx_save(&ix, cx->xfr, cx->key, cx->nnc) != 0)
+        fprintf(stderr, "%s: index not written.\n", cx->xfr);
+    ckpt_idx_free(&ix);
+
+    close(cx->fdi);
+    cx->fdi = STDIN_FILENO;
+    close(cx->fdo);
+    cx->fdo = STDOUT_FILENO;
+
+    return st;
+}
+
+// decrypt "fn", which must have the .sb1 suffix
+
+int iocom_dec_file(stricat_t *cx, const char *fn)
+{
+    int len, st;
+
+    snprintf(cx->xfr, CBYT_XFER, "%s", fn);
+
+    len = strlen(cx->xfr);
+    if (len <= 4 || strcmp(&cx->xfr[len - 4], ".sb1") != 0) {
+        fprintf(stderr, "Unknown file type: %s\n", cx->xfr);
+        return 1;
+    }
+    if ((cx->fdi = open(cx->xfr, O_RDONLY)) == -1) {
+        perror(cx->xfr);
+        cx->fdi = STDIN_FILENO;
+        return 1;
+    }
+    cx->xfr[len - 4] = 0;
+    if ((cx->fdo =
+        open(cx->xfr, O_RDWR | O_CREAT | O_TRUNC, 0664)) == -1) {
+        perror(cx->xfr);
+        cx->fdo = STDOUT_FILENO;
+        close(cx->fdi);
+        cx->fdi = STDIN_FILENO;
+        return 1;
+    }
+
+    st = iocom_dec(cx);
+
+    close(cx->fdi);
+    cx->fdi = STDIN_FILENO;
+    close(cx->fdo);
+    cx->fdo = STDOUT_FILENO;
+
+    return st;
+}
+
+// STRIBOB hash of file "fn" (keyed with cx->key if "keyed"), left in
+// cx->xfr
+
+int iocom_hash_file(stricat_t *cx, const char *fn, int keyed)
+{
+    int st;
+
+    if ((cx->fdi = open(fn, O_RDONLY)) == -1) {
+        perror(fn);
+        cx->fdi = STDIN_FILENO;
+        return 1;
+    }
+    sbob_clr(&cx->sbx);
+    if (keyed) {
+        sbob_put(&cx->sbx, BLNK_KEY, cx->key, CBYT_KEY);
+        sbob_fin(&cx->sbx, BLNK_KEY);
+    }
+    st = iocom_hash(cx);
+    close(cx->fdi);
+    cx->fdi = STDIN_FILENO;
+    if (st == 0)
+        sbob_get(&cx->sbx, BLNK_HASH, cx->xfr, CBYT_HASH);
+
+    return st;
+}
+
+// Streebog hash of file "fn", left in cx->xfr
+
+int iocom_streebog_file(stricat_t *cx, const char *fn, int hlen)
+{
+    int st;
+    streebog_t sbog;
+
+    if ((cx->fdi = open(fn, O_RDONLY)) == -1) {
+        perror(fn);
+        cx->fdi = STDIN_FILENO;
+        return 1;
+    }
+    streebog_init(&sbog, hlen);
+    st = iocom_streebog(cx, &sbog);
+    close(cx->fdi);
+    cx->fdi = STDIN_FILENO;
+    if (st == 0)
+        streebog_final(cx->xfr, &sbog);
+
+    return st;
+}
+
 // create pipes for execution
 
 int iocom_exec(stricat_t *cx, char *cmd)
@@ -218,6 +869,7 @@ int iocom_comms(stricat_t *cx, int here, int there)
 {
     int n, timeout;
     struct timeval tv;
+    struct iovec iov;
     fd_set rdset;
     const int wait_us[11] =
         { 0, 1000, 2000, 5000, 10000, 20000, 50000,
@@ -244,7 +896,9 @@ int iocom_comms(stricat_t *cx, int here, int there)
         }
 
         if (n > 0) {
-            if (write(cx->fdo, cx->xfr, n) != n) {
+            iov.iov_base = cx->xfr;
+            iov.iov_len = n;
+            if (ring_writev(cx->fdo, &iov, 1) != 0) {
                 perror("iocom_comms: write()");
                 break;
             }
@@ -6,16 +6,34 @@
 #define IOCOM_H
 
 #include "blnk.h"
+#include "streebog.h"
 
 // hash a file
 int iocom_hash(stricat_t *cx);
 
+// hash a file with Streebog
+int iocom_streebog(stricat_t *cx, streebog_t *sbog);
+
+// read the input once for the digests named in "ops", at most three of
+// 's' (STRIBOB, keyed with cx->key if "keyed"), 'g' and 'G' (Streebog
+// 256, 512), each computed by its own thread. the digests are left in
+// cx->xfr one after another, in the order of "ops"
+int iocom_multi(stricat_t *cx, int keyed, const char *ops);
+
 // encrypt an io stream
 int iocom_enc(stricat_t *cx);
 
 // decrypt an io stream
 int iocom_dec(stricat_t *cx);
 
+// the same on named files; "fn" is encrypted into "fn.sb1" and
+// "fn.sb1" decrypted into "fn". if "every" > 0, the decryption state
+// of every "every"th record is indexed in "fn.sb1.sbx" (see ckpt.h)
+int iocom_enc_file(stricat_t *cx, const char *fn, int every);
+int iocom_dec_file(stricat_t *cx, const char *fn);
+int iocom_hash_file(stricat_t *cx, const char *fn, int keyed);
+int iocom_streebog_file(stricat_t *cx, const char *fn, int hlen);
+
 // client
 int iocom_client(stricat_t *cx, char *hostname, int port);
 
@@ -5,6 +5,12 @@
 // Command line parsing etc.
 
 #include "iocom.h"
+#include "ckpt.h"
+#include "tree.h"
+#include "batch.h"
+#include "pool.h"
+#include "sb2.h"
+#include "walk.h"
 #include "streebog.h"
 
 // online help
@@ -27,6 +33,26 @@ const char usage[] =
 " -s         Hash stdin or files in STRIBOB BNLK mode (optionally keyed)\n"
 " -g         GOST R 34.11-2012 unkeyed Streebog hash with 256-bit output\n"
 " -G         GOST R 34.11-2012 unkeyed Streebog hash with 512-bit output\n"
+" -S         Parallel STRIBOB tree hash of stdin or files (optionally keyed)\n"
+" -L <size>  Tree hash leaf size, k/M/G suffixes allowed (default 1M)\n"
+" -j <n>     Number of threads (default: number of cpus); with -e, -d,\n"
+"            -g, -G on several files, process n at once (default: one)\n"
+" -r, --recursive  With -s, -g, -G: hash all files under directories,\n"
+"            printing a manifest of \"hash  path\" lines in path order\n"
+" --check <file>  With -s, -g, -G: verify the files in a manifest\n"
+" -R, --resume  With -s, -g, -G on files: only hash data appended since\n"
+"            the last run, using a state kept in FILE.sbs / .sg256 / .sg512\n"
+"            (trusts that the hashed part is unchanged; only keyed -s\n"
+"            states are protected against tampering)\n"
+" -B <size>  Encrypt in chunks of this size, k/M up to 16M (default 64k)\n"
+" -z         With -e, store holes of sparse files as zero runs; -d always\n"
+"            restores zero runs as holes\n"
+" -x <n>     With -e on files, index the state of every n:th record\n"
+"            in FILE.sb1.sbx for parallel (-j) and --range decryption\n"
+" -2         Encrypt to (or decrypt stdin from) the seekable, parallel\n"
+"            .sb2 format; -d picks it for files with the .sb2 suffix\n"
+" --range <off>:<len>  With -d on a .sb2 or .sb1 file, decrypt only\n"
+"            that range to stdout\n"
 "\n"
 "Communication via Blinker protocol:\n"
 " -p <port>  Specify TCP port (default 48879)\n"
@@ -35,6 +61,35 @@ const char usage[] =
 
 //c:dehf:k:lp:qt
 
+// parse a size with an optional k, M or G suffix; 0 on error
+
+static size_t parse_size(const char *str)
+{
+    char *ep;
+    unsigned long x;
+
+    x = strtoul(str, &ep, 0);
+    switch (*ep) {
+        case 'k':   x <<= 10;   ep++;   break;
+        case 'M':   x <<= 20;   ep++;   break;
+        case 'G':   x <<= 30;   ep++;   break;
+    }
+
+    return *ep == 0 ? x : 0;
+}
+
+// long options; those without a short one get codes above 0xFF
+#define OPT_RANGE   0x100
+#define OPT_CHECK   0x101
+
+static const struct option long_opts[] = {
+    { "resume", no_argument, NULL, 'R' },
+    { "recursive", no_argument, NULL, 'r' },
+    { "range", required_argument, NULL, OPT_RANGE },
+    { "check", required_argument, NULL, OPT_CHECK },
+    { NULL, 0, NULL, 0 }
+};
+
 int streebog_test();
 
 // main
@@ -50,7 +105,21 @@ int main(int argc, char **argv)
         streebog = 0,
         listen = 0,
         connect = 0,
-        keyset = 0;
+        keyset = 0,
+        resume = 0,
+        tree = 0,
+        sb2 = 0,                    // .sb2 format
+        range = 0,
+        recurse = 0,                // -r
+        sg256 = 0,                  // -g and -G given
+        sg512 = 0;
+    char ops[4];                    // digests of a single pass
+    char *check = NULL;             // --check manifest
+    uint64_t roff = 0, rlen = 0;    // --range
+    int threads = 0;                // threads; 0 = number of cpus
+    int every = 0;                  // .sb1 index interval
+    int cpus;
+    size_t leaf = TREE_LEAF;        // tree hash leaf size
 
     streebog_t sbog;                // streebog context (local)
     int port = 0xBEEF;              // 48879
@@ -68,7 +137,8 @@ int main(int argc, char **argv)
 
     // try to obtain the password from command line, file or prompt
     do {
-        st = getopt(argc, argv, "c:dehf:gGk:lp:qst");
+        st = getopt_long(argc, argv, "2B:c:dehf:gGj:k:lL:p:qrRsStx:z",
+            long_opts, NULL);
         switch (st) {
 
             case 'h':   // help / usage
@@ -88,6 +158,73 @@ int main(int argc, char **argv)
                 hashing = 1;
                 break;
 
+            case 'S':   // tree hashing
+                hashing = 1;
+                tree = 1;
+                break;
+
+            case 'L':   // tree hash leaf size
+                leaf = parse_size(optarg);
+                if (leaf < TREE_LEAF_MIN || leaf > TREE_LEAF_MAX) {
+                    fprintf(stderr, "Illegal leaf size %s\n", optarg);
+                    goto cleanup;
+                }
+                break;
+
+            case 'j':   // threads
+                threads = atoi(optarg);
+                if (threads <= 0 || threads > 1024) {
+                    fprintf(stderr, "Illegal thread count %s\n", optarg);
+                    goto cleanup;
+                }
+                break;
+
+            case 'R':   // resume hashing from a checkpoint
+                resume = 1;
+                break;
+
+            case 'B':   // chunk size
+                cx->blk = parse_size(optarg);
+                if (cx->blk < 1 || cx->blk > CBYT_XMAX) {
+                    fprintf(stderr, "Illegal chunk size %s\n", optarg);
+                    goto cleanup;
+                }
+                break;
+
+            case 'z':   // sparse files
+                cx->hole = 1;
+                break;
+
+            case 'x':   // index the encrypted file
+                every = atoi(optarg);
+                if (every <= 0) {
+                    fprintf(stderr, "Illegal index interval %s\n", optarg);
+                    goto cleanup;
+                }
+                break;
+
+            case '2':   // seekable format
+                sb2 = 1;
+                break;
+
+            case 'r':   // directory trees
+                recurse = 1;
+                break;
+
+            case OPT_CHECK: // verify a manifest
+                check = optarg;
+                break;
+
+            case OPT_RANGE: // decrypt a range
+                roff = strtoull(optarg, &pt, 0);
+                if (*pt != ':' || (rlen = strtoull(pt + 1, &pt, 0),
+                    *pt != 0)) {
+                    fprintf(stderr, "Illegal range %s\n", optarg);
+                    goto cleanup;
+                }
+                range = 1;
+                break;
+
             case 'c':   // connect to a host
                 if (host != NULL) {
                     fprintf(stderr,
@@ -107,6 +244,8 @@ int main(int argc, char **argv)
             case 't':   // self-test
                 st = run_selftest();
                 printf("Compiled on " __DATE__ " " __TIME__ "\n");
+                printf("sbob_pi backend: %s\n", sbob_impl_name());
+                printf("sbob_pi fastest: %s\n", sbob_impl_tune());
                 printf("run_selftest() == %d\n", st);
                 goto cleanup;
                 break;
@@ -142,11 +281,13 @@ int main(int argc, char **argv)
             case 'g':   // hashing with streebog, 256-bit hash
                 streebog = 1;
                 hlen = 32;
+                sg256 = 1;
                 break;
 
             case 'G':   // hashing with streebog, 512-bit hash
                 streebog = 1;
                 hlen = 64;
+                sg512 = 1;
                 break;
 
             case 'k':   // password supplied
@@ -218,9 +359,9 @@ int main(int argc, char **argv)
     } while (st != -1);
 
     // see that there's a single op defined
-    if (encrypt + decrypt + hashing + connect + listen + streebog != 1) {
-        fprintf(stderr,
-            "Exactly one of -d, -e, -g, -G, -s, -c, -l must be set.\n");
+    if (encrypt + decrypt + (hashing || streebog) + connect + listen != 1) {
+        fprintf(stderr, "Exactly one of -d, -e, -g, -G, -s, -c, -l must "
+            "be set\n(-s, -g and -G may be combined).\n");
         st = 1;
         goto cleanup;
     }
@@ -233,6 +374,58 @@ int main(int argc, char **argv)
         goto cleanup;
     }
 
+    // checkpoints are kept per file
+    if (resume && (!(hashing || streebog) || tree || optind >= argc)) {
+        fprintf(stderr, "--resume needs -s, -g or -G and file names.\n");
+        st = 1;
+        goto cleanup;
+    }
+
+    // several digests in one pass
+    i = 0;
+    if (hashing)
+        ops[i++] = 's';
+    if (sg256)
+        ops[i++] = 'g';
+    if (sg512)
+        ops[i++] = 'G';
+    ops[i] = 0;
+    if (i > 1 && (tree || resume || recurse || check != NULL)) {
+        fprintf(stderr, "-S, -R, -r and --check take a single hash.\n");
+        st = 1;
+        goto cleanup;
+    }
+    if (i > 1 && keyset && !hashing) {
+        fprintf(stderr, "Streebog is an unkeyed hash. Try -s\n");
+        st = 1;
+        goto cleanup;
+    }
+
+    // manifests
+    if ((recurse || check != NULL) && (!(hashing || streebog) || tree ||
+        resume || (check != NULL) == (optind < argc))) {
+        fprintf(stderr, "-r needs -s, -g or -G and file names, "
+            "--check the same without them.\n");
+        st = 1;
+        goto cleanup;
+    }
+
+    // ranges are read from a single file
+    if (range && (!decrypt || argc - optind != 1)) {
+        fprintf(stderr, "--range needs -d and one .sb1 or .sb2 file.\n");
+        st = 1;
+        goto cleanup;
+    }
+
+    // bulk hashing; pick the permutation by measured speed. the choice
+    // must be made before any threads are started
+    if (hashing || streebog)
+        sbob_impl_tune();
+    else
+        sbob_impl_name();
+    if ((cpus = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+        cpus = 1;
+
     // networking
 
     if (connect || listen) {
@@ -252,19 +445,83 @@ int main(int argc, char **argv)
         goto cleanup;
     }
 
+    // -s, -g, -G together; the input is read only once
+
+    if (ops[0] != 0 && ops[1] != 0) {
+
+        do {
+            pt = optind < argc ? argv[optind] : NULL;
+            if (pt != NULL && (cx->fdi = open(pt, O_RDONLY)) == -1) {
+                perror(pt);
+                st = 1;
+                goto cleanup;
+            }
+            st = iocom_multi(cx, keyset, ops);
+            if (pt != NULL) {
+                close(cx->fdi);
+                cx->fdi = STDIN_FILENO;
+            }
+            if (st != 0)
+                goto cleanup;
+
+            len = 0;
+            for (i = 0; ops[i] != 0; i++) {
+                hlen = ops[i] == 's' ? CBYT_HASH : ops[i] == 'g' ? 32 : 64;
+                for (; hlen > 0; hlen--)
+                    printf("%02x", cx->xfr[len++] & 0xFF);
+                if (pt != NULL)
+                    printf("  %s", pt);
+                printf("\n");
+            }
+        } while (++optind < argc);
+
+        goto cleanup;
+    }
+
+    // directory trees and manifests
+
+    if (recurse || check != NULL) {
+        if (streebog && keyset) {
+            fprintf(stderr, "Streebog is an unkeyed hash. Try -s\n");
+            st = 1;
+            goto cleanup;
+        }
+        if (threads == 0)
+            threads = cpus;
+        i = hashing ? 's' : hlen == 32 ? 'g' : 'G';
+        if (check != NULL)
+            st = walk_check(cx, i, keyset, check, threads);
+        else
+            st = walk_hash(cx, i, keyset, &argv[optind], argc - optind,
+                threads);
+        goto cleanup;
+    }
+
     // hashing
 
     if (hashing) {
 
         st = 0;
 
+        if (threads == 0)
+            threads = cpus;
+
         if (optind >= argc) {
+            if (tree) {
+                if ((st = tree_hash(cx, keyset, leaf, threads)) != 0)
+                    goto cleanup;
+                for (i = 0; i < CBYT_HASH; i++)
+                    printf("%02x", cx->xfr[i] & 0xFF);
+                printf("\n");
+                goto cleanup;
+            }
             sbob_clr(&cx->sbx);
             if (keyset) {
                 sbob_put(&cx->sbx, BLNK_KEY, cx->key, CBYT_KEY);
                 sbob_fin(&cx->sbx, BLNK_KEY);       
             }
-            st = iocom_hash(cx);
+            if ((st = iocom_hash(cx)) != 0)
+                goto cleanup;
             sbob_get(&cx->sbx, BLNK_HASH, cx->xfr, CBYT_HASH);
             for (i = 0; i < CBYT_HASH; i++)
                 printf("%02x", cx->xfr[i] & 0xFF);
@@ -272,22 +529,40 @@ int main(int argc, char **argv)
             goto cleanup;
         }
 
+        // many files at once
+        if (!tree && !resume && argc - optind > 1) {
+            st = batch_hash(cx, keyset, &argv[optind], argc - optind,
+                threads);
+            goto cleanup;
+        }
+
         for (; optind < argc; optind++) {
 
-            if ((cx->fdi = open(argv[optind], O_RDONLY)) == -1) {
-                perror(optarg);
-                goto cleanup;
-            }
-            sbob_clr(&cx->sbx);
-            if (keyset) {
-                sbob_put(&cx->sbx, BLNK_KEY, cx->key, CBYT_KEY);
-                sbob_fin(&cx->sbx, BLNK_KEY);
+            if (resume) {
+                if ((st = ckpt_hash(cx, argv[optind], 's', keyset)) != 0)
+                    goto cleanup;
+            } else {
+                if ((cx->fdi = open(argv[optind], O_RDONLY)) == -1) {
+                    perror(optarg);
+                    goto cleanup;
+                }
+                if (tree) {
+                    st = tree_hash(cx, keyset, leaf, threads);
+                } else {
+                    sbob_clr(&cx->sbx);
+                    if (keyset) {
+                        sbob_put(&cx->sbx, BLNK_KEY, cx->key, CBYT_KEY);
+                        sbob_fin(&cx->sbx, BLNK_KEY);
+                    }
+                    st = iocom_hash(cx);
+                    sbob_get(&cx->sbx, BLNK_HASH, cx->xfr, CBYT_HASH);
+                }
+                close(cx->fdi);
+                cx->fdi = STDIN_FILENO;
+                if (st != 0)
+                    goto cleanup;
             }
-            st = iocom_hash(cx);
-            close(cx->fdi);
-            cx->fdi = STDIN_FILENO;
 
-            sbob_get(&cx->sbx, BLNK_HASH, cx->xfr, CBYT_HASH);
             for (i = 0; i < CBYT_HASH; i++)
                 printf("%02x", cx->xfr[i] & 0xFF);
             printf("  %s\n", argv[optind]);
@@ -305,8 +580,8 @@ int main(int argc, char **argv)
 
         if (optind >= argc) {
             streebog_init(&sbog, hlen);
-            while ((len = read(cx->fdi, cx->xfr, CBYT_XFER)) > 0)
-                streebog_update(&sbog, cx->xfr, len);
+            if ((st = iocom_streebog(cx, &sbog)) != 0)
+                goto cleanup;
             streebog_final(cx->xfr, &sbog);
             for (i = 0; i < hlen; i++)
                 printf("%02x", cx->xfr[i] & 0xFF);       
@@ -314,19 +589,24 @@ int main(int argc, char **argv)
             goto cleanup;
         }
 
+        // worker threads for -j
+        if (!resume && threads > 1 && argc - optind > 1) {
+            st = pool_files(cx, 'g', hlen, &argv[optind], argc - optind,
+                threads);
+            goto cleanup;
+        }
+
         for (; optind < argc; optind++) {
 
-            if ((cx->fdi = open(argv[optind], O_RDONLY)) == -1) {
-                perror(optarg);
-                goto cleanup;
+            if (resume) {
+                if ((st = ckpt_hash(cx, argv[optind],
+                    hlen == 32 ? 'g' : 'G', 0)) != 0)
+                    goto cleanup;
+            } else {
+                if ((st = iocom_streebog_file(cx, argv[optind], hlen)) != 0)
+                    goto cleanup;
             }
-            streebog_init(&sbog, hlen);
-            while ((len = read(cx->fdi, cx->xfr, CBYT_XFER)) > 0)
-                streebog_update(&sbog, cx->xfr, len);
-            close(cx->fdi);
-            cx->fdi = STDIN_FILENO;
 
-            streebog_final(cx->xfr, &sbog);
             for (i = 0; i < hlen; i++)
                 printf("%02x", cx->xfr[i] & 0xFF);
             printf("  %s\n", argv[optind]);
@@ -338,32 +618,27 @@ int main(int argc, char **argv)
     if (encrypt) {
 
         if (optind >= argc) {
-            st = iocom_enc(cx);
+            if (sb2)
+                st = sb2_enc(cx->key, cx->fdi, cx->fdo,
+                    cx->blk != 0 ? cx->blk : SB2_CHUNK,
+                    threads > 0 ? threads : cpus);
+            else
+                st = iocom_enc(cx);
             goto cleanup;
         }
 
-        for (; optind < argc; optind++) {
-
-            st = 1;
-
-            if ((cx->fdi = open(argv[optind], O_RDONLY)) == -1) {
-                perror(argv[optind]);
-                goto cleanup;
-            }
-            snprintf(cx->xfr, CBYT_XFER, "%s.sb1", argv[optind]);   
-            if ((cx->fdo =
-                open(cx->xfr, O_WRONLY | O_CREAT | O_TRUNC, 0664)) == -1) {
-                perror(cx->xfr);
-                goto cleanup;
-            }  
-
-            st = iocom_enc(cx);
+        if (threads > 1 && argc - optind > 1) {
+            st = pool_files(cx, sb2 ? 'E' : 'e', every, &argv[optind],
+                argc - optind, threads);
+            goto cleanup;
+        }
 
-            close(cx->fdi);
-            cx->fdi = STDIN_FILENO;
-            close(cx->fdo);
-            cx->fdo = STDOUT_FILENO;
-   
+        for (; optind < argc; optind++) {
+            if (sb2)
+                st = sb2_enc_file(cx, argv[optind],
+                    threads > 0 ? threads : cpus);
+            else
+                st = iocom_enc_file(cx, argv[optind], every);
             if (st != 0)
                 goto cleanup;
         }
@@ -374,38 +649,35 @@ int main(int argc, char **argv)
     if (decrypt) {
 
         if (optind >= argc) {
-            st = iocom_dec(cx);
+            if (sb2)
+                st = sb2_dec(cx->key, cx->fdi, cx->fdo,
+                    threads > 0 ? threads : cpus);
+            else
+                st = iocom_dec(cx);
             goto cleanup;
         }
 
-        for (; optind < argc; optind++) {
-
-            st = 1;
-            snprintf(cx->xfr, CBYT_XFER, "%s", argv[optind]);
-
-            len = strlen(cx->xfr);
-            if (len <= 4 || strcmp(&cx->xfr[len - 4], ".sb1") != 0) {
-                fprintf(stderr, "Unknown file type: %s\n", cx->xfr);
-                goto cleanup;
-            }
-            if ((cx->fdi = open(cx->xfr, O_RDONLY)) == -1) {
-                perror(cx->xfr);
-                goto cleanup;
-            }  
-            cx->xfr[len - 4] = 0;
-            if ((cx->fdo =
-                    open(cx->xfr, O_WRONLY | O_CREAT | O_TRUNC, 0664)) == -1) {
-                perror(cx->xfr);
-                goto cleanup;
-            }  
+        if (range) {
+            if (sb2_name(argv[optind]))
+                st = sb2_range(cx, argv[optind], roff, rlen);
+            else
+                st = ckpt_range(cx, argv[optind], roff, rlen);
+            goto cleanup;
+        }
 
-            st = iocom_dec(cx);
+        if (threads > 1 && argc - optind > 1) {
+            st = pool_files(cx, 'd', 0, &argv[optind], argc - optind,
+                threads);
+            goto cleanup;
+        }
 
-            close(cx->fdi);
-            cx->fdi = STDIN_FILENO;
-            close(cx->fdo);
-            cx->fdo = STDOUT_FILENO;
-   
+        for (; optind < argc; optind++) {
+            if (sb2_name(argv[optind]))
+                st = sb2_dec_file(cx, argv[optind],
+                    threads > 0 ? threads : cpus);
+            else
+                st = ckpt_dec_file(cx, argv[optind],
+                    threads > 0 ? threads : cpus);
             if (st != 0)
                 goto cleanup;
         }
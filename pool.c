@@ -0,0 +1,156 @@
+// pool.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Worker threads for file arguments. Files are handed out in argument
+// order; each worker has a private stricat_t with the same key.
+
+#include "pool.h"
+#include "iocom.h"
+#include "sb2.h"
+#include <pthread.h>
+
+typedef struct {
+    const stricat_t *cx;                    // key
+    int op, arg;                            // hash length or interval
+    char * const *fn;
+    int n, next, stop;
+    int *st;                                // status per file
+    uint8_t *done;
+    uint8_t *md;                            // hash of each file
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+} pool_t;
+
+// worker
+
+static void *pool_work(void *arg)
+{
+    int i, st;
+    stricat_t *wx;
+    pool_t *pl = (pool_t *) arg;
+
+    // without a context, fail the next file and start no more
+    if ((wx = malloc(sizeof(stricat_t))) == NULL) {
+        pthread_mutex_lock(&pl->mtx);
+        if (pl->next < pl->n) {
+            i = pl->next++;
+            pl->st[i] = CBERRNO;
+            pl->done[i] = 1;
+        }
+        pl->stop = 1;
+        pthread_cond_broadcast(&pl->cv);
+        pthread_mutex_unlock(&pl->mtx);
+        return NULL;
+    }
+    memset(wx, 0x00, sizeof(stricat_t));
+    memcpy(wx->key, pl->cx->key, CBYT_KEY);
+    wx->blk = pl->cx->blk;
+    wx->hole = pl->cx->hole;
+    wx->fdi = STDIN_FILENO;
+    wx->fdo = STDOUT_FILENO;
+
+    for (;;) {
+        pthread_mutex_lock(&pl->mtx);
+        if (pl->stop || pl->next >= pl->n) {
+            pthread_mutex_unlock(&pl->mtx);
+            break;
+        }
+        i = pl->next++;
+        pthread_mutex_unlock(&pl->mtx);
+
+        switch (pl->op) {
+            case 'e':
+                st = iocom_enc_file(wx, pl->fn[i], pl->arg);
+                break;
+            case 'E':
+                st = sb2_enc_file(wx, pl->fn[i], 1);
+                break;
+            case 'd':
+                if (sb2_name(pl->fn[i]))
+                    st = sb2_dec_file(wx, pl->fn[i], 1);
+                else
+                    st = iocom_dec_file(wx, pl->fn[i]);
+                break;
+            default:
+                st = iocom_streebog_file(wx, pl->fn[i], pl->arg);
+                if (st == 0)
+                    memcpy(&pl->md[i * pl->arg], wx->xfr, pl->arg);
+                break;
+        }
+
+        pthread_mutex_lock(&pl->mtx);
+        pl->st[i] = st;
+        pl->done[i] = 1;
+        pthread_cond_broadcast(&pl->cv);
+        pthread_mutex_unlock(&pl->mtx);
+    }
+
+    memset(wx, 0x00, sizeof(stricat_t));
+    free(wx);
+
+    return NULL;
+}
+
+// run the pool; this thread reports in order
+
+int pool_files(stricat_t *cx, int op, int arg, char * const fn[], int n,
+    int threads)
+{
+    int i, j, k, st;
+    pthread_t *tid;
+    pool_t pl;
+
+    memset(&pl, 0, sizeof(pl));
+    pl.cx = cx;
+    pl.op = op;
+    pl.arg = arg;
+    pl.fn = fn;
+    pl.n = n;
+    pl.st = calloc(n, sizeof(int));
+    pl.done = calloc(n, 1);
+    pl.md = op == 'g' ? calloc(n, arg) : NULL;
+    tid = malloc(threads * sizeof(pthread_t));
+    if (pl.st == NULL || pl.done == NULL || tid == NULL ||
+        (op == 'g' && pl.md == NULL)) {
+        st = CBERRNO;
+        goto done;
+    }
+    pthread_mutex_init(&pl.mtx, NULL);
+    pthread_cond_init(&pl.cv, NULL);
+
+    for (k = 0; k < threads; k++) {
+        if (pthread_create(&tid[k], NULL, pool_work, &pl) != 0)
+            break;
+    }
+    st = k == 0 ? CBERRNO : 0;
+
+    pthread_mutex_lock(&pl.mtx);
+    for (i = 0; i < n && st == 0; i++) {
+        while (!pl.done[i])
+            pthread_cond_wait(&pl.cv, &pl.mtx);
+        if ((st = pl.st[i]) != 0) {
+            pl.stop = 1;
+            break;
+        }
+        if (op == 'g') {
+            for (j = 0; j < arg; j++)
+                printf("%02x", pl.md[i * arg + j]);
+            printf("  %s\n", fn[i]);
+        }
+    }
+    pthread_mutex_unlock(&pl.mtx);
+
+    for (i = 0; i < k; i++)
+        pthread_join(tid[i], NULL);
+    pthread_cond_destroy(&pl.cv);
+    pthread_mutex_destroy(&pl.mtx);
+
+done:
+    free(tid);
+    free(pl.st);
+    free(pl.done);
+    free(pl.md);
+
+    return st;
+}
@@ -0,0 +1,18 @@
+// pool.h
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "blnk.h"
+
+// run op 'e' (encrypt, indexing every "arg"th record), 'E' (encrypt to
+// .sb2), 'd' (decrypt, .sb1 or .sb2 by suffix) or 'g' (Streebog, "arg"
+// bytes) on files fn[0..n-1] with "threads" threads, each with its own
+// copy of cx. hashes are printed in argument order. after a failure no
+// more files are started, and the status of the first failed one returned
+int pool_files(stricat_t *cx, int op, int arg, char * const fn[], int n,
+    int threads);
+
+#endif
@@ -0,0 +1,434 @@
+// ring.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Pipelined file i/o: a reader thread, the calling thread and a writer
+// thread pass a ring of buffers around, so that reading, cryptography
+// and writing overlap. Slots are used strictly in order, so records
+// come out exactly as they would from a single loop.
+
+#define _GNU_SOURCE
+#include "ring.h"
+#include <poll.h>
+
+// read() that fails with rg->halt set instead of blocking once
+// ring_stop() has been called. only pipes and sockets can block; they
+// are polled together with the wake-up pipe
+
+static int ring_rd(ring_t *rg, void *buf, int len)
+{
+    struct pollfd pfd[2];
+
+    if (rg->wake[0] >= 0) {
+        pfd[0].fd = rg->fdi;
+        pfd[0].events = POLLIN;
+        pfd[1].fd = rg->wake[0];
+        pfd[1].events = POLLIN;
+        if (poll(pfd, 2, -1) < 0) {
+            if (errno != EINTR)
+                return -1;
+        } else if (pfd[1].revents != 0) {
+            rg->halt = 1;
+            return -1;
+        }
+        if (pfd[0].revents == 0) {
+            errno = EINTR;
+            return -1;
+        }
+    }
+
+    return read(rg->fdi, buf, len);
+}
+
+// read exactly "len" bytes of records unless the input ends, through
+// the read-ahead buffer. bytes read or -1
+
+static int ring_read(ring_t *rg, void *buf, int len)
+{
+    int i, n;
+
+    for (i = 0; i < len; i += n) {
+        if (rg->rap >= rg->ral) {
+            n = ring_rd(rg, rg->rab, RING_AHEAD);
+            if (n == -1 && errno == EINTR) {
+                n = 0;
+                continue;
+            }
+            if (n < 0)
+                return -1;
+            if (n == 0)
+                break;
+            rg->rap = 0;
+            rg->ral = n;
+        }
+        n = len - i < rg->ral - rg->rap ? len - i : rg->ral - rg->rap;
+        memcpy(((uint8_t *) buf) + i, rg->rab + rg->rap, n);
+        rg->rap += n;
+    }
+
+    return i;
+}
+
+// write all of iov. 0 on success
+
+int ring_writev(int fd, struct iovec *iov, int iovcnt)
+{
+    ssize_t r;
+
+    while (iovcnt > 0) {
+        if ((r = writev(fd, iov, iovcnt)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        while (iovcnt > 0 && (size_t) r >= iov->iov_len) {
+            r -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = ((uint8_t *) iov->iov_base) + r;
+            iov->iov_len -= r;
+        }
+    }
+
+    return 0;
+}
+
+// zeros to fd. holes are made by seeking past the end, or punched if
+// the file had data there
+
+int ring_skip(int fd, uint64_t len)
+{
+    int fl;
+    off_t p, q;
+    uint8_t zero[0x1000];
+    struct iovec iov;
+    struct stat st;
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        (fl = fcntl(fd, F_GETFL)) != -1 && (fl & O_APPEND) == 0 &&
+        (p = lseek(fd, 0, SEEK_CUR)) >= 0 &&
+        (q = lseek(fd, len, SEEK_CUR)) >= 0) {
+        if (p < st.st_size && fallocate(fd, FALLOC_FL_PUNCH_HOLE |
+            FALLOC_FL_KEEP_SIZE, p, (q < st.st_size ? q : st.st_size) - p))
+            return -1;
+        return q > st.st_size ? ftruncate(fd, q) : 0;
+    }
+
+    memset(zero, 0, sizeof(zero));
+    while (len > 0) {
+        iov.iov_base = zero;
+        iov.iov_len = len < sizeof(zero) ? len : sizeof(zero);
+        len -= iov.iov_len;
+        if (ring_writev(fd, &iov, 1) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+// a failed slot; quietly if it was ring_stop() that ended the read
+
+static int ring_fail(ring_t *rg, ring_slot_t *sl, const char *msg)
+{
+    if (!rg->halt)
+        perror(msg);
+    sl->len = -1;
+
+    return 1;
+}
+
+// fill one slot from the input. 1 if it was the last one
+
+static int ring_fill(ring_t *rg, ring_slot_t *sl)
+{
+    int i, n;
+    uint64_t len;
+    uint8_t *p, hl[CBYT_HOLE];
+
+    // a single read, as in a plain read() loop, or a full slot
+    if ((rg->mode & RING_REC) == 0) {
+        sl->len = 0;
+        for (;;) {
+            n = ring_rd(rg, sl->buf + sl->len, rg->size - sl->len);
+            if (n == -1 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            sl->len += n;
+            if ((rg->mode & RING_FULL) == 0 || sl->len >= (int) rg->size)
+                break;
+        }
+        if (n < 0) {
+            if (!rg->halt)
+                perror("ring: read error");
+            sl->len = -1;
+        }
+        return sl->len <= 0;
+    }
+
+    // a record
+    if (ring_read(rg, sl->lbf, CBYT_LBUF) != CBYT_LBUF)
+        return ring_fail(rg, sl, "iocom_dec: error reading chunk size");
+    len = 0;
+    for (i = 0; i < CBYT_LBUF; i++)
+        len += ((uint64_t) sl->lbf[i]) << (8 * i);
+
+    // a zero-run record
+    sl->hole = 0;
+    if (len == BLNK_HOLE) {
+        sl->len = 0;
+        if (ring_read(rg, hl, CBYT_HOLE) != CBYT_HOLE ||
+            ring_read(rg, sl->mac, CBYT_MAC) != CBYT_MAC)
+            return ring_fail(rg, sl, "iocom_dec: error reading zero run");
+        for (i = CBYT_HOLE - 1; i >= 0; i--)
+            sl->hole = (sl->hole << 8) | hl[i];
+        return 0;
+    }
+    if (len > CBYT_XMAX) {
+        fprintf(stderr, "iocom_dec: chunk format / integrity error.\n");
+        sl->len = -1;
+        return 1;
+    }
+    if (len > sl->cap) {
+        if ((p = realloc(sl->buf, len)) == NULL) {
+            perror("iocom_dec");
+            sl->len = -1;
+            return 1;
+        }
+        sl->buf = p;
+        sl->cap = len;
+    }
+    sl->len = len;
+    if (ring_read(rg, sl->buf, sl->len) != sl->len)
+        return ring_fail(rg, sl, "iocom_dec: error reading encrypted chunk");
+    if (ring_read(rg, sl->mac, CBYT_MAC) != CBYT_MAC)
+        return ring_fail(rg, sl, "iocom_dec: error reading MAC");
+
+    // leave a regular file just after the records
+    if (sl->len == 0 && rg->ral > rg->rap)
+        lseek(rg->fdi, rg->rap - rg->ral, SEEK_CUR);
+
+    return sl->len == 0;
+}
+
+// reader thread
+
+static void *ring_reader(void *arg)
+{
+    int last;
+    ring_t *rg = (ring_t *) arg;
+    ring_slot_t *sl;
+
+    do {
+        // wait for a free slot
+        pthread_mutex_lock(&rg->mtx);
+        while (!rg->stop && rg->nr - (rg->mode & (RING_WREC | RING_WRAW) ?
+            rg->nw : rg->nc) >= RING_SLOTS)
+            pthread_cond_wait(&rg->cv, &rg->mtx);
+        if (rg->stop) {
+            pthread_mutex_unlock(&rg->mtx);
+            break;
+        }
+        sl = &rg->slot[rg->nr % RING_SLOTS];
+        pthread_mutex_unlock(&rg->mtx);
+
+        last = ring_fill(rg, sl);
+
+        pthread_mutex_lock(&rg->mtx);
+        rg->nr++;
+        rg->eof = last;
+        pthread_cond_broadcast(&rg->cv);
+        pthread_mutex_unlock(&rg->mtx);
+    } while (!last);
+
+    return NULL;
+}
+
+// writer thread
+
+static void *ring_writer(void *arg)
+{
+    int i, k, n, st;
+    ring_t *rg = (ring_t *) arg;
+    ring_slot_t *sl;
+    struct iovec iov[3 * RING_SLOTS];
+
+    for (;;) {
+        pthread_mutex_lock(&rg->mtx);
+        while (rg->nw == rg->nc && !rg->stop)
+            pthread_cond_wait(&rg->cv, &rg->mtx);
+        if (rg->nw == rg->nc) {
+            pthread_mutex_unlock(&rg->mtx);
+            break;
+        }
+        k = rg->nc - rg->nw;                // all that are ready
+        pthread_mutex_unlock(&rg->mtx);
+
+        // a zero run on its own, or the records up to the next one
+        sl = &rg->slot[rg->nw % RING_SLOTS];
+        if (sl->hole != 0) {
+            k = 1;
+            st = ring_skip(rg->fdo, sl->hole);
+        } else {
+            n = 0;
+            for (i = 0; i < k; i++) {
+                sl = &rg->slot[(rg->nw + i) % RING_SLOTS];
+                if (sl->hole != 0)
+                    break;
+                if (rg->mode & RING_WREC) {
+                    iov[n].iov_base = sl->lbf;
+                    iov[n++].iov_len = CBYT_LBUF;
+                }
+                if (sl->len > 0) {
+                    iov[n].iov_base = sl->buf;
+                    iov[n++].iov_len = sl->len;
+                }
+                if (rg->mode & RING_WREC) {
+                    iov[n].iov_base = sl->mac;
+                    iov[n++].iov_len = CBYT_MAC;
+                }
+            }
+            k = i;
+            st = n > 0 ? ring_writev(rg->fdo, iov, n) : 0;
+        }
+
+        if (st != 0) {
+            perror("ring: write error");
+            pthread_mutex_lock(&rg->mtx);
+            rg->err = 1;
+            rg->stop = 1;
+            pthread_cond_broadcast(&rg->cv);
+            pthread_mutex_unlock(&rg->mtx);
+            break;
+        }
+
+        pthread_mutex_lock(&rg->mtx);
+        rg->nw += k;
+        pthread_cond_broadcast(&rg->cv);
+        pthread_mutex_unlock(&rg->mtx);
+    }
+
+    return NULL;
+}
+
+// start
+
+int ring_start(ring_t *rg, int fdi, int fdo, int mode, size_t size)
+{
+    int i;
+    struct stat st;
+
+    memset(rg, 0, sizeof(ring_t));
+    rg->fdi = fdi;
+    rg->fdo = fdo;
+    rg->mode = mode;
+    rg->size = size;
+    rg->wake[0] = -1;
+    rg->wake[1] = -1;
+
+    for (i = 0; i < RING_SLOTS; i++) {
+        if ((rg->slot[i].buf = malloc(size)) == NULL) {
+            while (--i >= 0)
+                free(rg->slot[i].buf);
+            return CBERRNO;
+        }
+        rg->slot[i].cap = size;
+    }
+    if ((mode & RING_REC) && (rg->rab = malloc(RING_AHEAD)) == NULL) {
+        for (i = 0; i < RING_SLOTS; i++)
+            free(rg->slot[i].buf);
+        return CBERRNO;
+    }
+    pthread_mutex_init(&rg->mtx, NULL);
+    pthread_cond_init(&rg->cv, NULL);
+
+    // a reader blocked on a pipe or socket is woken up by ring_stop()
+    if (fstat(fdi, &st) != 0 || !S_ISREG(st.st_mode)) {
+        if (pipe(rg->wake) != 0) {
+            rg->wake[0] = -1;
+            rg->wake[1] = -1;
+            ring_stop(rg);
+            return CBERRNO;
+        }
+    }
+
+    if (pthread_create(&rg->rd, NULL, ring_reader, rg) != 0) {
+        ring_stop(rg);
+        return CBERRNO;
+    }
+    rg->run = 1;
+    if (mode & (RING_WREC | RING_WRAW)) {
+        if (pthread_create(&rg->wr, NULL, ring_writer, rg) != 0) {
+            ring_stop(rg);
+            return CBERRNO;
+        }
+        rg->run |= 2;
+    }
+
+    return 0;
+}
+
+// next input
+
+ring_slot_t *ring_next(ring_t *rg)
+{
+    ring_slot_t *sl;
+
+    pthread_mutex_lock(&rg->mtx);
+    while (rg->nc == rg->nr && !rg->eof && !rg->stop)
+        pthread_cond_wait(&rg->cv, &rg->mtx);
+    sl = rg->nc < rg->nr && !rg->err ? &rg->slot[rg->nc % RING_SLOTS] : NULL;
+    pthread_mutex_unlock(&rg->mtx);
+
+    return sl;
+}
+
+// hand over to the writer, or just free the slot
+
+void ring_done(ring_t *rg)
+{
+    pthread_mutex_lock(&rg->mtx);
+    rg->nc++;
+    pthread_cond_broadcast(&rg->cv);
+    pthread_mutex_unlock(&rg->mtx);
+}
+
+// shut down
+
+int ring_stop(ring_t *rg)
+{
+    int i, err;
+
+    // stop reading; the writer drains what has been processed
+    pthread_mutex_lock(&rg->mtx);
+    rg->stop = 1;
+    pthread_cond_broadcast(&rg->cv);
+    pthread_mutex_unlock(&rg->mtx);
+
+    if (rg->wake[1] >= 0 && write(rg->wake[1], "", 1) != 1)
+        perror("ring: wake-up");
+    if (rg->run & 1)
+        pthread_join(rg->rd, NULL);
+    if (rg->run & 2)
+        pthread_join(rg->wr, NULL);
+
+    err = rg->err;
+    for (i = 0; i < 2; i++) {
+        if (rg->wake[i] >= 0)
+            close(rg->wake[i]);
+    }
+    pthread_cond_destroy(&rg->cv);
+    pthread_mutex_destroy(&rg->mtx);
+    for (i = 0; i < RING_SLOTS; i++) {
+        memset(rg->slot[i].buf, 0, rg->slot[i].cap);
+        free(rg->slot[i].buf);
+    }
+    if (rg->rab != NULL) {
+        memset(rg->rab, 0, RING_AHEAD);
+        free(rg->rab);
+    }
+
+    return err;
+}
@@ -0,0 +1,73 @@
+// ring.h
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+#ifndef RING_H
+#define RING_H
+
+#include "blnk.h"
+#include <pthread.h>
+
+// number of buffers in flight
+#define RING_SLOTS 8
+
+// read-ahead for records
+#define RING_AHEAD (4 * CBYT_XFER)
+
+// modes
+#define RING_RAW    0x00        // input: one read() per slot
+#define RING_REC    0x01        // input: lbf, payload, mac records
+#define RING_WREC   0x02        // output: lbf, payload, mac records
+#define RING_WRAW   0x04        // output: payload only
+#define RING_FULL   0x08        // input: fill raw slots, not one read()
+
+// one buffer of "cap" bytes. len is the payload length, -1 on error;
+// a zero-run record has len 0 and its length in "hole"
+typedef struct {
+    uint8_t lbf[CBYT_LBUF];
+    uint8_t mac[CBYT_MAC];
+    int len;
+    uint64_t hole;
+    size_t cap;
+    uint8_t *buf;
+} ring_slot_t;
+
+// a reader thread fills slots from fdi, the caller processes them in
+// order, and a writer thread (if any) writes them to fdo. records are
+// read through a read-ahead buffer, and whatever is ready is written
+// with a single writev()
+typedef struct {
+    int fdi, fdo, mode;
+    size_t size;                // raw slot size
+    pthread_t rd, wr;
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+    uint64_t nr, nc, nw;        // slots read, processed, written
+    int eof, err, stop;
+    int run;                    // threads running: 1 reader, 2 writer
+    int wake[2], halt;          // pipe to wake up a blocked reader
+    uint8_t *rab;               // RING_REC read-ahead buffer
+    int rap, ral;               // and position, length in it
+    ring_slot_t slot[RING_SLOTS];
+} ring_t;
+
+// start the threads, with slots of "size" bytes. records may be up to
+// CBYT_XMAX bytes; slots grow to fit them. 0 on success
+int ring_start(ring_t *rg, int fdi, int fdo, int mode, size_t size);
+
+// next slot in order, NULL when the input has ended
+ring_slot_t *ring_next(ring_t *rg);
+
+// processing of the slot from ring_next() is done
+void ring_done(ring_t *rg);
+
+// wait for the output and free everything. 0 if there were no errors
+int ring_stop(ring_t *rg);
+
+// write all of iov, retrying short writes. 0 on success
+int ring_writev(int fd, struct iovec *iov, int iovcnt);
+
+// write "len" zero bytes: a hole in a regular file, zeros otherwise
+int ring_skip(int fd, uint64_t len);
+
+#endif
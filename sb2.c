@@ -0,0 +1,594 @@
+// sb2.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Seekable chunked encryption (.sb2). Streams are processed in groups of
+// chunks; the chunks of a group are sealed or opened by a number of
+// threads, while the group is read and written in one go.
+
+#include "sb2.h"
+#include "ring.h"
+#include <pthread.h>
+
+// most chunks in a group, and most bytes in a group buffer
+#define SB2_GROUP 256
+#define SB2_GROUP_MAX 0x4000000
+
+// a group of k chunks in buf, each at a multiple of cs + SB2_TAG. all
+// have cs bytes of payload except the last, which has "last"
+typedef struct {
+    const sbob_t *init;
+    uint32_t cs;
+    uint64_t first;                         // index of the first chunk
+    uint8_t *buf;
+    int k, dec;
+    size_t last;
+    int next, bad;                          // next chunk, first failed
+    pthread_mutex_t mtx;
+} sb2_job_t;
+
+// little-endian fields
+
+static void sb2_put(uint8_t *p, uint64_t x, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        p[i] = x >> (8 * i);
+}
+
+static uint64_t sb2_get(const uint8_t *p, int n)
+{
+    int i;
+    uint64_t x;
+
+    x = 0;
+    for (i = n - 1; i >= 0; i--)
+        x = (x << 8) | p[i];
+
+    return x;
+}
+
+// read "len" bytes unless the input ends; with pread() if off >= 0
+
+static ssize_t sb2_read(int fd, void *buf, size_t len, off_t off)
+{
+    size_t i;
+    ssize_t r;
+
+    for (i = 0; i < len; i += r) {
+        if (off >= 0)
+            r = pread(fd, ((uint8_t *) buf) + i, len - i, off + i);
+        else
+            r = read(fd, ((uint8_t *) buf) + i, len - i);
+        if (r < 0 && errno == EINTR) {
+            r = 0;
+            continue;
+        }
+        if (r < 0)
+            return r;
+        if (r == 0)
+            break;
+    }
+
+    return i;
+}
+
+static int sb2_write(int fd, const void *buf, size_t len)
+{
+    struct iovec iov;
+
+    iov.iov_base = (void *) buf;
+    iov.iov_len = len;
+
+    return ring_writev(fd, &iov, 1);
+}
+
+// keyed state after the nonce
+
+static void sb2_init(sbob_t *sb, const uint8_t *key, const uint8_t *nnc)
+{
+    sbob_clr(sb);
+    sbob_put(sb, BLNK_KEY, key, CBYT_KEY);
+    sbob_fin(sb, BLNK_KEY);
+    sbob_put(sb, BLNK_NPUB, nnc, CBYT_NPUB);
+    sbob_fin(sb, BLNK_NPUB);
+}
+
+// seal or open the chunk at p in place: "len" bytes and the tag.
+// flag 1 is the trailer. 0 on success
+
+static int sb2_chunk(const sbob_t *init, uint64_t i, uint32_t cs,
+    int fl, uint64_t tot, uint8_t *p, size_t len, int dec)
+{
+    int st;
+    uint8_t ad[24];
+    sbob_t sb;
+
+    sb2_put(ad, i, 8);
+    sb2_put(ad + 8, cs, 4);
+    sb2_put(ad + 12, fl, 4);
+    sb2_put(ad + 16, tot, 8);
+
+    sb = *init;
+    st = 0;
+    if (dec)
+        st = sbob_open(&sb, 0, ad, 24, p, p, len, p + len, SB2_TAG);
+    else
+        sbob_seal(&sb, 0, ad, 24, p, p, len, p + len, SB2_TAG);
+    memset(&sb, 0, sizeof(sb));
+
+    return st;
+}
+
+// worker for a group
+
+static void *sb2_work(void *arg)
+{
+    int j;
+    sb2_job_t *jb = (sb2_job_t *) arg;
+
+    for (;;) {
+        pthread_mutex_lock(&jb->mtx);
+        j = jb->next++;
+        pthread_mutex_unlock(&jb->mtx);
+        if (j >= jb->k)
+            break;
+
+        if (sb2_chunk(jb->init, jb->first + j, jb->cs, 0, 0,
+            jb->buf + (size_t) j * (jb->cs + SB2_TAG),
+            j < jb->k - 1 ? jb->cs : jb->last, jb->dec) != 0) {
+            pthread_mutex_lock(&jb->mtx);
+            if (j < jb->bad)
+                jb->bad = j;
+            pthread_mutex_unlock(&jb->mtx);
+        }
+    }
+
+    return NULL;
+}
+
+// process a group. index of the first chunk that failed, or k
+
+static int sb2_group(sb2_job_t *jb, int threads)
+{
+    int i, n;
+    pthread_t tid[SB2_GROUP];
+
+    jb->next = 0;
+    jb->bad = jb->k;
+    if (threads > jb->k)
+        threads = jb->k;
+    for (n = 0; n < threads - 1; n++) {
+        if (pthread_create(&tid[n], NULL, sb2_work, jb) != 0)
+            break;
+    }
+    sb2_work(jb);
+    for (i = 0; i < n; i++)
+        pthread_join(tid[i], NULL);
+
+    return jb->bad;
+}
+
+// chunks per group
+
+static int sb2_groupsize(uint32_t cs, int threads)
+{
+    int b;
+
+    b = 4 * threads;
+    if (b > SB2_GROUP)
+        b = SB2_GROUP;
+    while (b > 1 && (size_t) b * (cs + SB2_TAG) > SB2_GROUP_MAX)
+        b--;
+
+    return b;
+}
+
+// encrypt a stream
+
+int sb2_enc(const uint8_t key[CBYT_KEY], int fdi, int fdo, uint32_t cs,
+    int threads)
+{
+    uint8_t nnc[CBYT_NPUB];
+
+    blnk_rand(nnc, CBYT_NPUB);
+
+    return sb2_enc_nnc(key, nnc, fdi, fdo, cs, threads);
+}
+
+int sb2_enc_nnc(const uint8_t key[CBYT_KEY], const uint8_t nnc[CBYT_NPUB],
+    int fdi, int fdo, uint32_t cs, int threads)
+{
+    int b, st;
+    ssize_t r;
+    uint64_t tot;
+    uint8_t hdr[SB2_HDR], trl[SB2_TRL], *p;
+    sbob_t init;
+    sb2_job_t jb;
+
+    if (cs < 1 || cs > SB2_CHUNK_MAX)
+        return CBERRNO;
+    if (threads < 1)
+        threads = 1;
+    b = sb2_groupsize(cs, threads);
+
+    memset(&jb, 0, sizeof(jb));
+    if ((jb.buf = malloc((size_t) b * (cs + SB2_TAG))) == NULL)
+        return CBERRNO;
+    pthread_mutex_init(&jb.mtx, NULL);
+
+    memcpy(hdr, "sb2\x01", 4);
+    sb2_put(hdr + 4, cs, 4);
+    memcpy(hdr + 8, nnc, CBYT_NPUB);
+    sb2_init(&init, key, hdr + 8);
+    jb.init = &init;
+    jb.cs = cs;
+    jb.dec = 0;
+
+    st = 0;
+    tot = 0;
+    if (sb2_write(fdo, hdr, SB2_HDR) != 0) {
+        perror("sb2_enc: error writing header");
+        st = CBERRNO;
+    }
+
+    // groups of chunks
+    for (r = cs; st == 0 && r == cs; jb.first += jb.k) {
+        jb.k = 0;
+        jb.last = cs;
+        while (jb.k < b) {
+            p = jb.buf + (size_t) jb.k * (cs + SB2_TAG);
+            if ((r = sb2_read(fdi, p, cs, -1)) <= 0)
+                break;
+            jb.k++;
+            tot += r;
+            if (r < cs) {
+                jb.last = r;
+                break;
+            }
+        }
+        if (r < 0) {
+            perror("sb2_enc: read error");
+            st = CBERRNO;
+            break;
+        }
+        if (jb.k == 0)
+            break;
+
+        sb2_group(&jb, threads);
+        if (sb2_write(fdo, jb.buf, (size_t) (jb.k - 1) *
+            (cs + SB2_TAG) + jb.last + SB2_TAG) != 0) {
+            perror("sb2_enc: error writing chunk");
+            st = CBERRNO;
+        }
+    }
+
+    // authenticated length
+    if (st == 0) {
+        sb2_put(trl, tot, 8);
+        sb2_chunk(&init, jb.first, cs, 1, tot, trl + 8, 0, 0);
+        if (sb2_write(fdo, trl, SB2_TRL) != 0) {
+            perror("sb2_enc: error writing trailer");
+            st = CBERRNO;
+        }
+    }
+
+    pthread_mutex_destroy(&jb.mtx);
+    memset(&init, 0, sizeof(init));
+    memset(jb.buf, 0, (size_t) b * (cs + SB2_TAG));
+    free(jb.buf);
+
+    return st;
+}
+
+// check the header
+
+static int sb2_header(const uint8_t *hdr, uint32_t *cs)
+{
+    if (memcmp(hdr, "sb2\x01", 4) != 0)
+        return CBERRNO;
+    *cs = sb2_get(hdr + 4, 4);
+    if (*cs < 1 || *cs > SB2_CHUNK_MAX)
+        return CBERRNO;
+
+    return 0;
+}
+
+// decrypt a stream
+
+int sb2_dec(const uint8_t key[CBYT_KEY], int fdi, int fdo, int threads)
+{
+    int b, j, st, eof;
+    uint32_t cs;
+    size_t cap, have, dat, rem;
+    ssize_t r;
+    uint64_t tot;
+    uint8_t hdr[SB2_HDR];
+    sbob_t init;
+    sb2_job_t jb;
+    struct iovec iov[SB2_GROUP];
+
+    if (sb2_read(fdi, hdr, SB2_HDR, -1) != SB2_HDR ||
+        sb2_header(hdr, &cs) != 0) {
+        fprintf(stderr, "sb2_dec: not a .sb2 stream.\n");
+        return CBERRNO;
+    }
+    if (threads < 1)
+        threads = 1;
+    b = sb2_groupsize(cs, threads);
+
+    // a group and the trailer, which is only known at the end
+    memset(&jb, 0, sizeof(jb));
+    cap = (size_t) b * (cs + SB2_TAG) + SB2_TRL;
+    if ((jb.buf = malloc(cap)) == NULL)
+        return CBERRNO;
+    pthread_mutex_init(&jb.mtx, NULL);
+    sb2_init(&init, key, hdr + 8);
+    jb.init = &init;
+    jb.cs = cs;
+    jb.dec = 1;
+
+    st = 0;
+    tot = 0;
+    have = 0;
+    do {
+        if ((r = sb2_read(fdi, jb.buf + have, cap - have, -1)) < 0) {
+            perror("sb2_dec: read error");
+            st = CBERRNO;
+            break;
+        }
+        have += r;
+        eof = have < cap;
+
+        // the chunks
+        dat = have - SB2_TRL;
+        jb.k = b;
+        jb.last = cs;
+        if (eof) {
+            rem = have < SB2_TRL ? 0 : dat % (cs + SB2_TAG);
+            if (have < SB2_TRL || (rem > 0 && rem <= SB2_TAG)) {
+                fprintf(stderr, "sb2_dec: chunk format error.\n");
+                st = CBERRNO;
+                break;
+            }
+            jb.k = dat / (cs + SB2_TAG) + (rem > 0);
+            if (rem > 0)
+                jb.last = rem - SB2_TAG;
+        }
+        if (jb.k > 0) {
+            j = sb2_group(&jb, threads);
+
+            // plaintext up to the first failed chunk
+            for (b = 0; b < j; b++) {
+                iov[b].iov_base = jb.buf + (size_t) b * (cs + SB2_TAG);
+                iov[b].iov_len = b < jb.k - 1 ? cs : jb.last;
+            }
+            if (j > 0 && ring_writev(fdo, iov, j) != 0) {
+                perror("sb2_dec: plaintext write error");
+                st = CBERRNO;
+                break;
+            }
+            if (j < jb.k) {
+                fprintf(stderr, "sb2_dec: chunk integrity error!\n");
+                st = CBERRNO;
+                break;
+            }
+            b = sb2_groupsize(cs, threads);
+            tot += (uint64_t) (jb.k - 1) * cs + jb.last;
+            jb.first += jb.k;
+        }
+
+        // keep the possible trailer
+        if (!eof) {
+            memmove(jb.buf, jb.buf + cap - SB2_TRL, SB2_TRL);
+            have = SB2_TRL;
+        }
+    } while (!eof);
+
+    // check the length
+    if (st == 0 && (sb2_get(jb.buf + dat, 8) != tot ||
+        sb2_chunk(&init, jb.first, cs, 1, tot, jb.buf + dat + 8, 0, 1))) {
+        fprintf(stderr, "sb2_dec: final integrity error!\n");
+        st = CBERRNO;
+    }
+
+    pthread_mutex_destroy(&jb.mtx);
+    memset(&init, 0, sizeof(init));
+    memset(jb.buf, 0, cap);
+    free(jb.buf);
+
+    return st;
+}
+
+// "fn" into "fn.sb2"
+
+int sb2_enc_file(stricat_t *cx, const char *fn, int threads)
+{
+    int st;
+
+    if ((cx->fdi = open(fn, O_RDONLY)) == -1) {
+        perror(fn);
+        cx->fdi = STDIN_FILENO;
+        return 1;
+    }
+    snprintf(cx->xfr, CBYT_XFER, "%s.sb2", fn);
+    if ((cx->fdo = open(cx->xfr, O_WRONLY | O_CREAT | O_TRUNC, 0664)) == -1) {
+        perror(cx->xfr);
+        cx->fdo = STDOUT_FILENO;
+        close(cx->fdi);
+        cx->fdi = STDIN_FILENO;
+        return 1;
+    }
+
+    st = sb2_enc(cx->key, cx->fdi, cx->fdo,
+        cx->blk != 0 ? cx->blk : SB2_CHUNK, threads);
+
+    close(cx->fdi);
+    cx->fdi = STDIN_FILENO;
+    close(cx->fdo);
+    cx->fdo = STDOUT_FILENO;
+
+    return st;
+}
+
+int sb2_name(const char *fn)
+{
+    size_t len;
+
+    len = strlen(fn);
+
+    return len > 4 && strcmp(&fn[len - 4], ".sb2") == 0;
+}
+
+// "fn.sb2" into "fn"
+
+int sb2_dec_file(stricat_t *cx, const char *fn, int threads)
+{
+    int len, st;
+
+    snprintf(cx->xfr, CBYT_XFER, "%s", fn);
+    len = strlen(cx->xfr);
+    if (!sb2_name(cx->xfr)) {
+        fprintf(stderr, "Unknown file type: %s\n", cx->xfr);
+        return 1;
+    }
+    if ((cx->fdi = open(cx->xfr, O_RDONLY)) == -1) {
+        perror(cx->xfr);
+        cx->fdi = STDIN_FILENO;
+        return 1;
+    }
+    cx->xfr[len - 4] = 0;
+    if ((cx->fdo = open(cx->xfr, O_WRONLY | O_CREAT | O_TRUNC, 0664)) == -1) {
+        perror(cx->xfr);
+        cx->fdo = STDOUT_FILENO;
+        close(cx->fdi);
+        cx->fdi = STDIN_FILENO;
+        return 1;
+    }
+
+    st = sb2_dec(cx->key, cx->fdi, cx->fdo, threads);
+
+    close(cx->fdi);
+    cx->fdi = STDIN_FILENO;
+    close(cx->fdo);
+    cx->fdo = STDOUT_FILENO;
+
+    return st;
+}
+
+// open for random access
+
+int sb2_open(sb2_t *f, const uint8_t key[CBYT_KEY], int fd)
+{
+    uint64_t n;
+    uint8_t hdr[SB2_HDR], trl[SB2_TRL];
+    struct stat st;
+
+    memset(f, 0, sizeof(sb2_t));
+    f->fd = fd;
+    if (fstat(fd, &st) != 0 || st.st_size < SB2_HDR + SB2_TRL ||
+        sb2_read(fd, hdr, SB2_HDR, 0) != SB2_HDR ||
+        sb2_header(hdr, &f->cs) != 0 ||
+        sb2_read(fd, trl, SB2_TRL, st.st_size - SB2_TRL) != SB2_TRL)
+        return CBERRNO;
+
+    // the size must match the length; then check the trailer
+    f->len = sb2_get(trl, 8);
+    n = (f->len + f->cs - 1) / f->cs;
+    if (f->len > (uint64_t) st.st_size ||
+        (uint64_t) st.st_size != SB2_HDR + f->len + n * SB2_TAG + SB2_TRL)
+        return CBERRNO;
+    sb2_init(&f->init, key, hdr + 8);
+    if (sb2_chunk(&f->init, n, f->cs, 1, f->len, trl + 8, 0, 1) != 0 ||
+        (f->buf = malloc(f->cs + SB2_TAG)) == NULL) {
+        memset(&f->init, 0, sizeof(sbob_t));
+        return CBERRNO;
+    }
+    f->cur = ~0llu;
+
+    return 0;
+}
+
+// random access read
+
+ssize_t sb2_pread(sb2_t *f, void *buf, size_t len, uint64_t off)
+{
+    size_t i, n, o, clen;
+    uint64_t c;
+
+    if (off >= f->len)
+        return 0;
+    if (len > f->len - off)
+        len = f->len - off;
+
+    for (i = 0; i < len; i += n) {
+        c = (off + i) / f->cs;
+        o = (off + i) % f->cs;
+        clen = f->len - c * f->cs < f->cs ? f->len - c * f->cs : f->cs;
+        if (c != f->cur) {
+            f->cur = ~0llu;
+            if (sb2_read(f->fd, f->buf, clen + SB2_TAG, SB2_HDR +
+                c * (f->cs + SB2_TAG)) != (ssize_t) (clen + SB2_TAG) ||
+                sb2_chunk(&f->init, c, f->cs, 0, 0, f->buf, clen, 1) != 0)
+                return -1;
+            f->cur = c;
+        }
+        n = clen - o < len - i ? clen - o : len - i;
+        memcpy(((uint8_t *) buf) + i, f->buf + o, n);
+    }
+
+    return len;
+}
+
+void sb2_close(sb2_t *f)
+{
+    if (f->buf != NULL) {
+        memset(f->buf, 0, f->cs + SB2_TAG);
+        free(f->buf);
+    }
+    memset(f, 0, sizeof(sb2_t));
+}
+
+// a range of a file
+
+int sb2_range(stricat_t *cx, const char *fn, uint64_t off, uint64_t len)
+{
+    int fd, st;
+    ssize_t r;
+    sb2_t f;
+
+    if ((fd = open(fn, O_RDONLY)) == -1) {
+        perror(fn);
+        return 1;
+    }
+    if (sb2_open(&f, cx->key, fd) != 0) {
+        fprintf(stderr, "%s: not a valid .sb2 file.\n", fn);
+        close(fd);
+        return CBERRNO;
+    }
+
+    st = 0;
+    while (len > 0) {
+        r = sb2_pread(&f, cx->xfr, len < CBYT_XFER ? len : CBYT_XFER, off);
+        if (r < 0) {
+            fprintf(stderr, "%s: chunk integrity error!\n", fn);
+            st = CBERRNO;
+            break;
+        }
+        if (r == 0)
+            break;
+        if (sb2_write(cx->fdo, cx->xfr, r) != 0) {
+            perror("sb2_range: write error");
+            st = CBERRNO;
+            break;
+        }
+        off += r;
+        len -= r;
+    }
+
+    sb2_close(&f);
+    close(fd);
+
+    return st;
+}
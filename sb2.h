@@ -0,0 +1,71 @@
+// sb2.h
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Seekable .sb2 container. Unlike .sb1, each chunk is sealed on its
+// own, so chunks can be processed in parallel and read in any order:
+//
+//  header  "sb2" 0x01, chunk size (32-bit LE), nonce (CBYT_NPUB)
+//  chunk i ciphertext (chunk size bytes, last one shorter) and tag
+//  trailer plaintext length (64-bit LE) and tag
+//
+// Each chunk is a sbob_seal() record starting from the state that has
+// absorbed BLNK_KEY key and BLNK_NPUB nonce. Its 24-byte BLNK_AAD is
+// the chunk index, chunk size and a flag (64, 32 and 32 bits) and the
+// plaintext length. For data chunks the flag and the length are 0; the
+// trailer is an empty record with flag 1 and index equal to the number
+// of chunks, so the file can't be truncated or extended.
+
+#ifndef SB2_H
+#define SB2_H
+
+#include "blnk.h"
+
+#define SB2_HDR     (8 + CBYT_NPUB)
+#define SB2_TAG     16
+#define SB2_TRL     (8 + SB2_TAG)
+#define SB2_CHUNK   0x10000
+#define SB2_CHUNK_MAX 0x4000000
+
+// random-access reader
+typedef struct {
+    int fd;
+    uint32_t cs;                            // chunk size
+    uint64_t len;                           // plaintext length
+    sbob_t init;                            // after key and nonce
+    uint8_t *buf;                           // one chunk and tag
+    uint64_t cur;                           // chunk in buf, or ~0
+} sb2_t;
+
+// encrypt fdi to fdo in chunks of "cs" bytes, with "threads" threads
+int sb2_enc(const uint8_t key[CBYT_KEY], int fdi, int fdo, uint32_t cs,
+    int threads);
+
+// the same with a given nonce, for known-answer tests
+int sb2_enc_nnc(const uint8_t key[CBYT_KEY], const uint8_t nnc[CBYT_NPUB],
+    int fdi, int fdo, uint32_t cs, int threads);
+
+// decrypt fdi to fdo. fails if any chunk or the trailer does not verify;
+// the plaintext before the failed chunk has been written by then
+int sb2_dec(const uint8_t key[CBYT_KEY], int fdi, int fdo, int threads);
+
+// "fn" to "fn.sb2" and back
+int sb2_enc_file(stricat_t *cx, const char *fn, int threads);
+int sb2_dec_file(stricat_t *cx, const char *fn, int threads);
+
+// 1 if "fn" has the .sb2 suffix
+int sb2_name(const char *fn);
+
+// decrypt "len" bytes at "off" of the .sb2 file "fn" to cx->fdo
+int sb2_range(stricat_t *cx, const char *fn, uint64_t off, uint64_t len);
+
+// open a .sb2 file for random access, checking the header and trailer
+int sb2_open(sb2_t *f, const uint8_t key[CBYT_KEY], int fd);
+
+// pread() of the plaintext: up to "len" bytes from offset "off". -1 if
+// a chunk fails to verify
+ssize_t sb2_pread(sb2_t *f, void *buf, size_t len, uint64_t off);
+
+void sb2_close(sb2_t *f);
+
+#endif
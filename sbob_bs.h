@@ -0,0 +1,1283 @@
+// sbob_bs.h
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Bitsliced LPS transform, included by sbob_pi_bs.c once for each word
+// type SBOB_BS_T (with function names SBOB_BS(name)). A state is held as
+// eight bit planes: bit 8 * j + i of x[b] is bit b of byte i of word j.
+// There are no table lookups; the S-box and L are computed with logic.
+//
+// Generated by sbob_bs_gen.py from the tables of sbob_tab64.c; edit
+// that script rather than this file.
+
+// 8 x 8 bit matrix transpose within each 64-bit word
+
+static inline void SBOB_BS(tr8)(SBOB_BS_T *y, const SBOB_BS_T *x)
+{
+    SBOB_BS_T a, t;
+
+    a = *x;
+    t = (a ^ (a >> 7)) & 0x00AA00AA00AA00AAllu;
+    a = a ^ t ^ (t << 7);
+    t = (a ^ (a >> 14)) & 0x0000CCCC0000CCCCllu;
+    a = a ^ t ^ (t << 14);
+    t = (a ^ (a >> 28)) & 0x00000000F0F0F0F0llu;
+    *y = a ^ t ^ (t << 28);
+}
+
+// 8 x 8 byte matrix transpose across eight words
+
+static inline void SBOB_BS(trb)(SBOB_BS_T x[8])
+{
+    int i, j;
+    SBOB_BS_T a, b;
+
+    for (i = 0; i < 4; i++) {
+        a = x[i];
+        b = x[i + 4];
+        x[i] = (a & 0x00000000FFFFFFFFllu) | (b << 32);
+        x[i + 4] = (a >> 32) | (b & 0xFFFFFFFF00000000llu);
+    }
+    for (j = 0; j < 8; j += 4) {
+        for (i = j; i < j + 2; i++) {
+            a = x[i];
+            b = x[i + 2];
+            x[i] = (a & 0x0000FFFF0000FFFFllu) |
+                ((b & 0x0000FFFF0000FFFFllu) << 16);
+            x[i + 2] = ((a >> 16) & 0x0000FFFF0000FFFFllu) |
+                (b & 0xFFFF0000FFFF0000llu);
+        }
+    }
+    for (i = 0; i < 8; i += 2) {
+        a = x[i];
+        b = x[i + 1];
+        x[i] = (a & 0x00FF00FF00FF00FFllu) |
+            ((b & 0x00FF00FF00FF00FFllu) << 8);
+        x[i + 1] = ((a >> 8) & 0x00FF00FF00FF00FFllu) |
+            (b & 0xFF00FF00FF00FF00llu);
+    }
+}
+
+// state words (little endian) to bit planes and back
+
+static inline void SBOB_BS(load)(SBOB_BS_T x[8])
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        SBOB_BS(tr8)(&x[i], &x[i]);
+    SBOB_BS(trb)(x);
+}
+
+static inline void SBOB_BS(store)(SBOB_BS_T x[8])
+{
+    int i;
+
+    SBOB_BS(trb)(x);
+    for (i = 0; i < 8; i++)
+        SBOB_BS(tr8)(&x[i], &x[i]);
+}
+
+// S-box as a Boolean circuit: algebraic normal form of each output bit
+// with shared subexpressions. x[b] holds bit b of all 64 state bytes.
+
+static inline void SBOB_BS(sbox)(SBOB_BS_T x[8])
+{
+    SBOB_BS_T p03, p05, p06, p07, p09, p0a, p0b, p0c, p0d, p0e, p0f, p11,
+        p12, p13, p14, p15, p16, p17, p18, p19, p1a, p1b, p1c, p1d, p1e,
+        p1f, p21, p22, p24, p25, p26, p27, p28, p29, p2a, p2b, p2c, p2d,
+        p2e, p2f, p30, p31, p32, p33, p34, p35, p36, p37, p38, p39, p3a,
+        p3b, p3c, p3d, p3e, p3f, p41, p42, p43, p44, p45, p46, p47, p48,
+        p49, p4a, p4b, p4c, p4d, p4e, p4f, p50, p51, p52, p53, p54, p55,
+        p56, p57, p58, p59, p5a, p5b, p5c, p5d, p5e, p5f, p60, p61, p62,
+        p63, p64, p65, p66, p67, p68, p69, p6a, p6b, p6c, p6d, p6e, p6f,
+        p70, p71, p72, p73, p74, p75, p76, p77, p78, p79, p7a, p7b, p7c,
+        p7d, p7e, p7f, p81, p82, p83, p84, p85, p86, p87, p88, p89, p8a,
+        p8b, p8c, p8d, p8e, p8f, p90, p91, p92, p93, p94, p95, p96, p97,
+        p98, p99, p9a, p9b, p9c, p9d, p9e, p9f, pa0, pa1, pa2, pa3, pa4,
+        pa5, pa6, pa7, pa8, pa9, paa, pab, pac, pad, pae, paf, pb0, pb1,
+        pb2, pb3, pb4, pb5, pb6, pb7, pb8, pb9, pba, pbb, pbc, pbd, pbe,
+        pbf, pc0, pc1, pc2, pc3, pc4, pc5, pc6, pc7, pc8, pc9, pca, pcb,
+        pcc, pcd, pce, pcf, pd0, pd1, pd2, pd3, pd4, pd5, pd6, pd7, pd8,
+        pd9, pda, pdb, pdc, pdd, pde, pdf, pe0, pe1, pe2, pe3, pe4, pe5,
+        pe6, pe7, pe8, pe9, pea, peb, pec, ped, pee, pef, pf0, pf1, pf2,
+        pf3, pf4, pf5, pf6, pf7, pf8, pf9, pfa, pfb, pfc, pfd, pfe, q0, q1,
+        q2, q3, q4, q5, q6, q7, q8, q9, q10, q11, q12, q13, q14, q15, q16,
+        q17, q18, q19, q20, q21, q22, q23, q24, q25, q26, q27, q28, q29,
+        q30, q31, q32, q33, q34, q35, q36, q37, q38, q39, q40, q41, q42,
+        q43, q44, q45, q46, q47, q48, q49, q50, q51, q52, q53, q54, q55,
+        q56, q57, q58, q59, q60, q61, q62, q63, q64, q65, q66, q67, q68,
+        q69, q70, q71, q72, q73, q74, q75, q76, q77, q78, q79, q80, q81,
+        q82, q83, q84, q85, q86, q87, q88, q89, q90, q91, q92, q93, q94,
+        q95, q96, q97, q98, q99, q100, q101, q102, q103, q104, q105, q106,
+        q107, q108, q109, q110, q111, q112, q113, q114, q115, q116, q117,
+        q118, q119, q120, q121, q122, q123, q124, q125, q126, q127, q128,
+        q129, q130, q131, q132, q133, q134, q135, q136, q137, q138, q139,
+        q140, q141, q142, q143, q144, q145, q146, q147, q148, q149, q150,
+        q151, q152, q153, q154, q155, q156, q157, q158, q159, q160, q161,
+        q162, q163, q164, q165, q166, q167, q168, q169, q170, q171, q172,
+        q173, q174, q175, q176, q177, q178, q179, q180, q181, q182, q183,
+        q184, q185, q186, q187, q188, q189, q190, q191, q192, q193, q194,
+        q195, q196, q197, q198, q199, q200, q201, q202, q203, q204, q205,
+        q206, q207, q208, q209, q210, q211, q212, q213, q214, q215, q216,
+        q217, q218, q219, q220, q221, q222, q223, q224, q225, y0, y1, y2,
+        y3, y4, y5, y6, y7;
+
+    p03 = x[1] & x[0];
+    p05 = x[2] & x[0];
+    p06 = x[2] & x[1];
+    p07 = p06 & x[0];
+    p09 = x[3] & x[0];
+    p0a = x[3] & x[1];
+    p0b = p0a & x[0];
+    p0c = x[3] & x[2];
+    p0d = p0c & x[0];
+    p0e = p0c & x[1];
+    p0f = p0e & x[0];
+    p11 = x[4] & x[0];
+    p12 = x[4] & x[1];
+    p13 = p12 & x[0];
+    p14 = x[4] & x[2];
+    p15 = p14 & x[0];
+    p16 = p14 & x[1];
+    p17 = p16 & x[0];
+    p18 = x[4] & x[3];
+    p19 = p18 & x[0];
+    p1a = p18 & x[1];
+    p1b = p1a & x[0];
+    p1c = p18 & x[2];
+    p1d = p1c & x[0];
+    p1e = p1c & x[1];
+    p1f = p1e & x[0];
+    p21 = x[5] & x[0];
+    p22 = x[5] & x[1];
+    p24 = x[5] & x[2];
+    p25 = p24 & x[0];
+    p26 = p24 & x[1];
+    p27 = p26 & x[0];
+    p28 = x[5] & x[3];
+    p29 = p28 & x[0];
+    p2a = p28 & x[1];
+    p2b = p2a & x[0];
+    p2c = p28 & x[2];
+    p2d = p2c & x[0];
+    p2e = p2c & x[1];
+    p2f = p2e & x[0];
+    p30 = x[5] & x[4];
+    p31 = p30 & x[0];
+    p32 = p30 & x[1];
+    p33 = p32 & x[0];
+    p34 = p30 & x[2];
+    p35 = p34 & x[0];
+    p36 = p34 & x[1];
+    p37 = p36 & x[0];
+    p38 = p30 & x[3];
+    p39 = p38 & x[0];
+    p3a = p38 & x[1];
+    p3b = p3a & x[0];
+    p3c = p38 & x[2];
+    p3d = p3c & x[0];
+    p3e = p3c & x[1];
+    p3f = p3e & x[0];
+    p41 = x[6] & x[0];
+    p42 = x[6] & x[1];
+    p43 = p42 & x[0];
+    p44 = x[6] & x[2];
+    p45 = p44 & x[0];
+    p46 = p44 & x[1];
+    p47 = p46 & x[0];
+    p48 = x[6] & x[3];
+    p49 = p48 & x[0];
+    p4a = p48 & x[1];
+    p4b = p4a & x[0];
+    p4c = p48 & x[2];
+    p4d = p4c & x[0];
+    p4e = p4c & x[1];
+    p4f = p4e & x[0];
+    p50 = x[6] & x[4];
+    p51 = p50 & x[0];
+    p52 = p50 & x[1];
+    p53 = p52 & x[0];
+    p54 = p50 & x[2];
+    p55 = p54 & x[0];
+    p56 = p54 & x[1];
+    p57 = p56 & x[0];
+    p58 = p50 & x[3];
+    p59 = p58 & x[0];
+    p5a = p58 & x[1];
+    p5b = p5a & x[0];
+    p5c = p58 & x[2];
+    p5d = p5c & x[0];
+    p5e = p5c & x[1];
+    p5f = p5e & x[0];
+    p60 = x[6] & x[5];
+    p61 = p60 & x[0];
+    p62 = p60 & x[1];
+    p63 = p62 & x[0];
+    p64 = p60 & x[2];
+    p65 = p64 & x[0];
+    p66 = p64 & x[1];
+    p67 = p66 & x[0];
+    p68 = p60 & x[3];
+    p69 = p68 & x[0];
+    p6a = p68 & x[1];
+    p6b = p6a & x[0];
+    p6c = p68 & x[2];
+    p6d = p6c & x[0];
+    p6e = p6c & x[1];
+    p6f = p6e & x[0];
+    p70 = p60 & x[4];
+    p71 = p70 & x[0];
+    p72 = p70 & x[1];
+    p73 = p72 & x[0];
+    p74 = p70 & x[2];
+    p75 = p74 & x[0];
+    p76 = p74 & x[1];
+    p77 = p76 & x[0];
+    p78 = p70 & x[3];
+    p79 = p78 & x[0];
+    p7a = p78 & x[1];
+    p7b = p7a & x[0];
+    p7c = p78 & x[2];
+    p7d = p7c & x[0];
+    p7e = p7c & x[1];
+    p7f = p7e & x[0];
+    p81 = x[7] & x[0];
+    p82 = x[7] & x[1];
+    p83 = p82 & x[0];
+    p84 = x[7] & x[2];
+    p85 = p84 & x[0];
+    p86 = p84 & x[1];
+    p87 = p86 & x[0];
+    p88 = x[7] & x[3];
+    p89 = p88 & x[0];
+    p8a = p88 & x[1];
+    p8b = p8a & x[0];
+    p8c = p88 & x[2];
+    p8d = p8c & x[0];
+    p8e = p8c & x[1];
+    p8f = p8e & x[0];
+    p90 = x[7] & x[4];
+    p91 = p90 & x[0];
+    p92 = p90 & x[1];
+    p93 = p92 & x[0];
+    p94 = p90 & x[2];
+    p95 = p94 & x[0];
+    p96 = p94 & x[1];
+    p97 = p96 & x[0];
+    p98 = p90 & x[3];
+    p99 = p98 & x[0];
+    p9a = p98 & x[1];
+    p9b = p9a & x[0];
+    p9c = p98 & x[2];
+    p9d = p9c & x[0];
+    p9e = p9c & x[1];
+    p9f = p9e & x[0];
+    pa0 = x[7] & x[5];
+    pa1 = pa0 & x[0];
+    pa2 = pa0 & x[1];
+    pa3 = pa2 & x[0];
+    pa4 = pa0 & x[2];
+    pa5 = pa4 & x[0];
+    pa6 = pa4 & x[1];
+    pa7 = pa6 & x[0];
+    pa8 = pa0 & x[3];
+    pa9 = pa8 & x[0];
+    paa = pa8 & x[1];
+    pab = paa & x[0];
+    pac = pa8 & x[2];
+    pad = pac & x[0];
+    pae = pac & x[1];
+    paf = pae & x[0];
+    pb0 = pa0 & x[4];
+    pb1 = pb0 & x[0];
+    pb2 = pb0 & x[1];
+    pb3 = pb2 & x[0];
+    pb4 = pb0 & x[2];
+    pb5 = pb4 & x[0];
+    pb6 = pb4 & x[1];
+    pb7 = pb6 & x[0];
+    pb8 = pb0 & x[3];
+    pb9 = pb8 & x[0];
+    pba = pb8 & x[1];
+    pbb = pba & x[0];
+    pbc = pb8 & x[2];
+    pbd = pbc & x[0];
+    pbe = pbc & x[1];
+    pbf = pbe & x[0];
+    pc0 = x[7] & x[6];
+    pc1 = pc0 & x[0];
+    pc2 = pc0 & x[1];
+    pc3 = pc2 & x[0];
+    pc4 = pc0 & x[2];
+    pc5 = pc4 & x[0];
+    pc6 = pc4 & x[1];
+    pc7 = pc6 & x[0];
+    pc8 = pc0 & x[3];
+    pc9 = pc8 & x[0];
+    pca = pc8 & x[1];
+    pcb = pca & x[0];
+    pcc = pc8 & x[2];
+    pcd = pcc & x[0];
+    pce = pcc & x[1];
+    pcf = pce & x[0];
+    pd0 = pc0 & x[4];
+    pd1 = pd0 & x[0];
+    pd2 = pd0 & x[1];
+    pd3 = pd2 & x[0];
+    pd4 = pd0 & x[2];
+    pd5 = pd4 & x[0];
+    pd6 = pd4 & x[1];
+    pd7 = pd6 & x[0];
+    pd8 = pd0 & x[3];
+    pd9 = pd8 & x[0];
+    pda = pd8 & x[1];
+    pdb = pda & x[0];
+    pdc = pd8 & x[2];
+    pdd = pdc & x[0];
+    pde = pdc & x[1];
+    pdf = pde & x[0];
+    pe0 = pc0 & x[5];
+    pe1 = pe0 & x[0];
+    pe2 = pe0 & x[1];
+    pe3 = pe2 & x[0];
+    pe4 = pe0 & x[2];
+    pe5 = pe4 & x[0];
+    pe6 = pe4 & x[1];
+    pe7 = pe6 & x[0];
+    pe8 = pe0 & x[3];
+    pe9 = pe8 & x[0];
+    pea = pe8 & x[1];
+    peb = pea & x[0];
+    pec = pe8 & x[2];
+    ped = pec & x[0];
+    pee = pec & x[1];
+    pef = pee & x[0];
+    pf0 = pe0 & x[4];
+    pf1 = pf0 & x[0];
+    pf2 = pf0 & x[1];
+    pf3 = pf2 & x[0];
+    pf4 = pf0 & x[2];
+    pf5 = pf4 & x[0];
+    pf6 = pf4 & x[1];
+    pf7 = pf6 & x[0];
+    pf8 = pf0 & x[3];
+    pf9 = pf8 & x[0];
+    pfa = pf8 & x[1];
+    pfb = pfa & x[0];
+    pfc = pf8 & x[2];
+    pfd = pfc & x[0];
+    pfe = pfc & x[1];
+    q0 = p06 ^ p1a;
+    q1 = pb3 ^ pf3;
+    q2 = p0c ^ p1f;
+    q3 = p0e ^ p18;
+    q4 = p21 ^ p60;
+    q5 = p22 ^ q1;
+    q6 = p28 ^ p3b;
+    q7 = p3f ^ p4a;
+    q8 = p54 ^ p97;
+    q9 = p57 ^ pd5;
+    q10 = p62 ^ q3;
+    q11 = p6c ^ q0;
+    q12 = p72 ^ pac;
+    q13 = p73 ^ p92;
+    q14 = p9a ^ pdf;
+    q15 = pa0 ^ q7;
+    q16 = pc0 ^ pe9;
+    q17 = pc3 ^ q6;
+    q18 = pf5 ^ q9;
+    q19 = q12 ^ q17;
+    q20 = q13 ^ q16;
+    q21 = p27 ^ pb7;
+    q22 = p2c ^ pf9;
+    q23 = p2f ^ pab;
+    q24 = p6d ^ pa5;
+    q25 = pbc ^ pc9;
+    q26 = pd1 ^ q21;
+    q27 = pe5 ^ q24;
+    q28 = q25 ^ q26;
+    q29 = p2b ^ pb4;
+    q30 = p05 ^ p8e;
+    q31 = p13 ^ q2;
+    q32 = p17 ^ p9e;
+    q33 = p1b ^ pbb;
+    q34 = p30 ^ pa1;
+    q35 = p35 ^ pcd;
+    q36 = p3d ^ q19;
+    q37 = p41 ^ p98;
+    q38 = p4c ^ q8;
+    q39 = p59 ^ q5;
+    q40 = p83 ^ q10;
+    q41 = p87 ^ pdb;
+    q42 = p99 ^ q14;
+    q43 = p9b ^ pbf;
+    q44 = pa6 ^ q4;
+    q45 = pda ^ q15;
+    q46 = pe8 ^ q18;
+    q47 = q11 ^ q20;
+    q48 = q32 ^ q44;
+    q49 = q34 ^ q46;
+    q50 = q37 ^ q42;
+    q51 = p03 ^ p5f;
+    q52 = p42 ^ p7d;
+    q53 = p46 ^ pd9;
+    q54 = p58 ^ q22;
+    q55 = p65 ^ q23;
+    q56 = p82 ^ p8a;
+    q57 = q27 ^ q28;
+    q58 = q51 ^ q55;
+    q59 = p25 ^ p31;
+    q60 = p43 ^ pcb;
+    q61 = pb0 ^ q29;
+    q62 = pc7 ^ q59;
+    q63 = x[2] ^ p47;
+    q64 = p09 ^ p95;
+    q65 = p1d ^ p6e;
+    q66 = p1e ^ pa9;
+    q67 = p32 ^ p5b;
+    q68 = x[6] ^ pba;
+    q69 = p4b ^ pb1;
+    q70 = p4e ^ p9d;
+    q71 = p50 ^ q31;
+    q72 = p5a ^ pd6;
+    q73 = p63 ^ p75;
+    q74 = p79 ^ pb5;
+    q75 = p85 ^ p88;
+    q76 = p86 ^ q40;
+    q77 = p89 ^ pc2;
+    q78 = p8f ^ q45;
+    q79 = pbe ^ q38;
+    q80 = pc5 ^ q35;
+    q81 = pdc ^ q30;
+    q82 = pe6 ^ pec;
+    q83 = peb ^ q48;
+    q84 = pfa ^ pfb;
+    q85 = q33 ^ q36;
+    q86 = q39 ^ q47;
+    q87 = q41 ^ q43;
+    q88 = q49 ^ q50;
+    q89 = q63 ^ q83;
+    q90 = q67 ^ q87;
+    q91 = q68 ^ q85;
+    q92 = q73 ^ q77;
+    q93 = p0d ^ q54;
+    q94 = p26 ^ p45;
+    q95 = p36 ^ pe2;
+    q96 = p37 ^ pa7;
+    q97 = p48 ^ paa;
+    q98 = p51 ^ pcc;
+    q99 = p84 ^ q56;
+    q100 = pa8 ^ q58;
+    q101 = pcf ^ q57;
+    q102 = pd3 ^ pde;
+    q103 = ped ^ pf0;
+    q104 = pfe ^ q53;
+    q105 = q96 ^ q101;
+    q106 = q102 ^ q104;
+    q107 = p16 ^ q61;
+    q108 = p4f ^ q60;
+    q109 = p55 ^ q62;
+    q110 = p56 ^ pce;
+    q111 = pee ^ q110;
+    q112 = p0f ^ p8b;
+    q113 = pb2 ^ pe4;
+    q114 = pc1 ^ pf8;
+    q115 = x[3] ^ q66;
+    q116 = p0b ^ p76;
+    q117 = x[4] ^ q70;
+    q118 = p14 ^ p91;
+    q119 = p29 ^ q69;
+    q120 = p5e ^ x[7];
+    q121 = p7b ^ p8c;
+    q122 = pad ^ q76;
+    q123 = pae ^ q71;
+    q124 = pc6 ^ pe3;
+    q125 = pd2 ^ q64;
+    q126 = pd8 ^ pfd;
+    q127 = pea ^ q75;
+    q128 = pf1 ^ q81;
+    q129 = q65 ^ q72;
+    q130 = q74 ^ q79;
+    q131 = q78 ^ q89;
+    q132 = q80 ^ q84;
+    q133 = q82 ^ q91;
+    q134 = q86 ^ q88;
+    q135 = q90 ^ q92;
+    q136 = q116 ^ q130;
+    q137 = q118 ^ q123;
+    q138 = q121 ^ q135;
+    q139 = q124 ^ q128;
+    q140 = q126 ^ q132;
+    q141 = q133 ^ q139;
+    q142 = p19 ^ p1c;
+    q143 = p39 ^ q52;
+    q144 = p44 ^ p6b;
+    q145 = p49 ^ p90;
+    q146 = p8d ^ pbd;
+    q147 = p94 ^ q95;
+    q148 = pb8 ^ q93;
+    q149 = pc4 ^ q99;
+    q150 = pd0 ^ pfc;
+    q151 = pd4 ^ pe7;
+    q152 = pdd ^ pf4;
+    q153 = pf6 ^ q94;
+    q154 = q97 ^ q98;
+    q155 = q103 ^ q106;
+    q156 = q105 ^ q149;
+    q157 = q142 ^ q150;
+    q158 = q144 ^ q147;
+    q159 = q145 ^ q148;
+    q160 = q152 ^ q154;
+    q161 = q155 ^ q158;
+    q162 = p11 ^ p96;
+    q163 = p34 ^ p5d;
+    q164 = p3c ^ q108;
+    q165 = p53 ^ p6a;
+    q166 = p64 ^ q109;
+    q167 = pb6 ^ q165;
+    q168 = pe1 ^ q107;
+    q169 = q111 ^ q166;
+    q170 = q162 ^ q168;
+    q171 = p07 ^ pf7;
+    q172 = p12 ^ p81;
+    q173 = p33 ^ p61;
+    q174 = p67 ^ p77;
+    q175 = pb9 ^ pca;
+    q176 = q100 ^ q112;
+    q177 = q113 ^ q114;
+    q178 = q172 ^ q177;
+    q179 = p2e ^ p7a;
+    q180 = p9c ^ q179;
+    q181 = p9f ^ pa4;
+    q182 = x[1] ^ pc8;
+    q183 = x[5] ^ p71;
+    q184 = p93 ^ q117;
+    q185 = pa2 ^ pef;
+    q186 = q115 ^ q120;
+    q187 = q119 ^ q122;
+    q188 = q125 ^ q127;
+    q189 = q129 ^ q131;
+    q190 = q134 ^ q136;
+    q191 = q138 ^ q140;
+    q192 = q141 ^ q184;
+    q193 = q183 ^ q188;
+    q194 = q185 ^ q190;
+    q195 = q187 ^ q189;
+    q196 = q191 ^ q194;
+    q197 = q192 ^ q195;
+    q198 = x[0] ^ p3a;
+    q199 = p2d ^ p66;
+    q200 = p38 ^ q151;
+    q201 = p3e ^ q143;
+    q202 = p6f ^ p7f;
+    q203 = q146 ^ q153;
+    q204 = q156 ^ q157;
+    q205 = q159 ^ q161;
+    q206 = q160 ^ q198;
+    q207 = q199 ^ q205;
+    q208 = q202 ^ q204;
+    q209 = q206 ^ q208;
+    q210 = p52 ^ q167;
+    q211 = p7c ^ pa3;
+    q212 = pe0 ^ q52;
+    q213 = q163 ^ q164;
+    q214 = q169 ^ q170;
+    q215 = q211 ^ q212;
+    q216 = p24 ^ p78;
+    q217 = p4d ^ q173;
+    q218 = q137 ^ q171;
+    q219 = q174 ^ q175;
+    q220 = q176 ^ q217;
+    q221 = q178 ^ q216;
+    q222 = q219 ^ q221;
+    q223 = p15 ^ p70;
+    q224 = p7e ^ q180;
+    q225 = q223 ^ q224;
+
+    y0 = p2a ^ q137 ^ q182 ^ q186 ^ q193 ^ q196 ^ q197;
+    y1 = p5c ^ p97 ^ q47 ^ q71 ^ q75 ^ q80 ^ q89 ^ q90 ^ q100 ^ q141 ^ q186 ^
+        q200 ^ q201 ^ q203 ^ q207 ^ q209;
+    y2 = ~(p1f ^ pd9 ^ q18 ^ q38 ^ q43 ^ q45 ^ q50 ^ q58 ^ q72 ^ q74 ^ q86 ^
+        q91 ^ q95 ^ q105 ^ q115 ^ q117 ^ q140 ^ q160 ^ q193 ^ q203 ^ q210 ^
+        q213 ^ q214 ^ q215);
+    y3 = ~(p28 ^ p47 ^ p5b ^ p60 ^ p8e ^ pfb ^ q27 ^ q33 ^ q53 ^ q56 ^ q64 ^
+        q78 ^ q92 ^ q94 ^ q97 ^ q103 ^ q122 ^ q127 ^ q134 ^ q159 ^ q164 ^
+        q214 ^ q218 ^ q220 ^ q222);
+    y4 = ~(p03 ^ pf2 ^ q8 ^ q11 ^ q14 ^ q22 ^ q39 ^ q61 ^ q161 ^ q167 ^ q171 ^
+        q173 ^ q178 ^ q181 ^ q197 ^ q209 ^ q213 ^ q225);
+    y5 = ~(p0a ^ p7e ^ paf ^ pba ^ pbb ^ pcd ^ pe0 ^ q5 ^ q19 ^ q23 ^ q29 ^
+        q30 ^ q31 ^ q40 ^ q49 ^ q57 ^ q60 ^ q65 ^ q69 ^ q70 ^ q79 ^ q84 ^
+        q112 ^ q120 ^ q125 ^ q131 ^ q138 ^ q143 ^ q146 ^ q151 ^ q163 ^ q169 ^
+        q181 ^ q182 ^ q207 ^ q222);
+    y6 = ~(p5d ^ p74 ^ pd2 ^ pd6 ^ pd7 ^ q0 ^ q1 ^ q15 ^ q20 ^ q35 ^ q36 ^
+        q41 ^ q48 ^ q62 ^ q66 ^ q76 ^ q82 ^ q88 ^ q93 ^ q107 ^ q108 ^ q111 ^
+        q113 ^ q119 ^ q136 ^ q153 ^ q156 ^ q175 ^ q176 ^ q180 ^ q181 ^ q201 ^
+        q210 ^ q218);
+    y7 = ~(p34 ^ p68 ^ p69 ^ p74 ^ p9d ^ paf ^ pb1 ^ pe4 ^ pf7 ^ q2 ^ q4 ^
+        q10 ^ q28 ^ q54 ^ q81 ^ q98 ^ q99 ^ q106 ^ q109 ^ q114 ^ q129 ^ q157 ^
+        q170 ^ q174 ^ q196 ^ q200 ^ q215 ^ q220 ^ q225);
+
+    x[0] = y0;
+    x[1] = y1;
+    x[2] = y2;
+    x[3] = y3;
+    x[4] = y4;
+    x[5] = y5;
+    x[6] = y6;
+    x[7] = y7;
+}
+
+// P and L: y has been transposed so that bit j of byte i of y[b] is bit b
+// of the S-box output at row j, column i. Each (j, b) selects a row of L.
+
+static inline void SBOB_BS(lin)(SBOB_BS_T z[8], const SBOB_BS_T y[8])
+{
+    SBOB_BS_T e;
+
+    e = y[0] & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] = e & 0x4F4F4F4F4F4F4F4Fllu;
+    z[1] = e & 0x7F7F7F7F7F7F7F7Fllu;
+    z[2] = e & 0xEAEAEAEAEAEAEAEAllu;
+    z[3] = e & 0x0404040404040404llu;
+    z[4] = e & 0x1010101010101010llu;
+    z[5] = e & 0x9090909090909090llu;
+    z[6] = e & 0xA2A2A2A2A2A2A2A2llu;
+    z[7] = e & 0x5555555555555555llu;
+    e = y[1] & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x5555555555555555llu;
+    z[1] ^= e & 0x4F4F4F4F4F4F4F4Fllu;
+    z[2] ^= e & 0x2A2A2A2A2A2A2A2Allu;
+    z[3] ^= e & 0xBFBFBFBFBFBFBFBFllu;
+    z[4] ^= e & 0x5151515151515151llu;
+    z[5] ^= e & 0x1010101010101010llu;
+    z[6] ^= e & 0x9090909090909090llu;
+    z[7] ^= e & 0xA2A2A2A2A2A2A2A2llu;
+    e = y[2] & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xA2A2A2A2A2A2A2A2llu;
+    z[1] ^= e & 0x5555555555555555llu;
+    z[2] ^= e & 0xEDEDEDEDEDEDEDEDllu;
+    z[3] ^= e & 0x8888888888888888llu;
+    z[4] ^= e & 0x1D1D1D1D1D1D1D1Dllu;
+    z[5] ^= e & 0x5151515151515151llu;
+    z[6] ^= e & 0x1010101010101010llu;
+    z[7] ^= e & 0x9090909090909090llu;
+    e = y[3] & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x9090909090909090llu;
+    z[1] ^= e & 0xA2A2A2A2A2A2A2A2llu;
+    z[2] ^= e & 0xC5C5C5C5C5C5C5C5llu;
+    z[3] ^= e & 0x7D7D7D7D7D7D7D7Dllu;
+    z[4] ^= e & 0x1818181818181818llu;
+    z[5] ^= e & 0x1D1D1D1D1D1D1D1Dllu;
+    z[6] ^= e & 0x5151515151515151llu;
+    z[7] ^= e & 0x1010101010101010llu;
+    e = y[4] & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x1010101010101010llu;
+    z[1] ^= e & 0x9090909090909090llu;
+    z[2] ^= e & 0xB2B2B2B2B2B2B2B2llu;
+    z[3] ^= e & 0xD5D5D5D5D5D5D5D5llu;
+    z[4] ^= e & 0x6D6D6D6D6D6D6D6Dllu;
+    z[5] ^= e & 0x1818181818181818llu;
+    z[6] ^= e & 0x1D1D1D1D1D1D1D1Dllu;
+    z[7] ^= e & 0x5151515151515151llu;
+    e = y[5] & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x5151515151515151llu;
+    z[1] ^= e & 0x1010101010101010llu;
+    z[2] ^= e & 0xC1C1C1C1C1C1C1C1llu;
+    z[3] ^= e & 0xE3E3E3E3E3E3E3E3llu;
+    z[4] ^= e & 0x8484848484848484llu;
+    z[5] ^= e & 0x6D6D6D6D6D6D6D6Dllu;
+    z[6] ^= e & 0x1818181818181818llu;
+    z[7] ^= e & 0x1D1D1D1D1D1D1D1Dllu;
+    e = y[6] & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x1D1D1D1D1D1D1D1Dllu;
+    z[1] ^= e & 0x5151515151515151llu;
+    z[2] ^= e & 0x0D0D0D0D0D0D0D0Dllu;
+    z[3] ^= e & 0xDCDCDCDCDCDCDCDCllu;
+    z[4] ^= e & 0xFEFEFEFEFEFEFEFEllu;
+    z[5] ^= e & 0x8484848484848484llu;
+    z[6] ^= e & 0x6D6D6D6D6D6D6D6Dllu;
+    z[7] ^= e & 0x1818181818181818llu;
+    e = y[7] & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x1818181818181818llu;
+    z[1] ^= e & 0x1D1D1D1D1D1D1D1Dllu;
+    z[2] ^= e & 0x4949494949494949llu;
+    z[3] ^= e & 0x1515151515151515llu;
+    z[4] ^= e & 0xC4C4C4C4C4C4C4C4llu;
+    z[5] ^= e & 0xFEFEFEFEFEFEFEFEllu;
+    z[6] ^= e & 0x8484848484848484llu;
+    z[7] ^= e & 0x6D6D6D6D6D6D6D6Dllu;
+    e = (y[0] >> 1) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x2C2C2C2C2C2C2C2Cllu;
+    z[1] ^= e & 0xB7B7B7B7B7B7B7B7llu;
+    z[2] ^= e & 0x8787878787878787llu;
+    z[3] ^= e & 0xD4D4D4D4D4D4D4D4llu;
+    z[4] ^= e & 0x5252525252525252llu;
+    z[5] ^= e & 0x0202020202020202llu;
+    z[6] ^= e & 0x0101010101010101llu;
+    z[7] ^= e & 0xE2E2E2E2E2E2E2E2llu;
+    e = (y[1] >> 1) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xE2E2E2E2E2E2E2E2llu;
+    z[1] ^= e & 0x2C2C2C2C2C2C2C2Cllu;
+    z[2] ^= e & 0x5555555555555555llu;
+    z[3] ^= e & 0x6565656565656565llu;
+    z[4] ^= e & 0x3636363636363636llu;
+    z[5] ^= e & 0x5252525252525252llu;
+    z[6] ^= e & 0x0202020202020202llu;
+    z[7] ^= e & 0x0101010101010101llu;
+    e = (y[2] >> 1) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x0101010101010101llu;
+    z[1] ^= e & 0xE2E2E2E2E2E2E2E2llu;
+    z[2] ^= e & 0x2D2D2D2D2D2D2D2Dllu;
+    z[3] ^= e & 0x5454545454545454llu;
+    z[4] ^= e & 0x6464646464646464llu;
+    z[5] ^= e & 0x3636363636363636llu;
+    z[6] ^= e & 0x5252525252525252llu;
+    z[7] ^= e & 0x0202020202020202llu;
+    e = (y[3] >> 1) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x0202020202020202llu;
+    z[1] ^= e & 0x0101010101010101llu;
+    z[2] ^= e & 0xE0E0E0E0E0E0E0E0llu;
+    z[3] ^= e & 0x2F2F2F2F2F2F2F2Fllu;
+    z[4] ^= e & 0x5656565656565656llu;
+    z[5] ^= e & 0x6464646464646464llu;
+    z[6] ^= e & 0x3636363636363636llu;
+    z[7] ^= e & 0x5252525252525252llu;
+    e = (y[4] >> 1) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x5252525252525252llu;
+    z[1] ^= e & 0x0202020202020202llu;
+    z[2] ^= e & 0x5353535353535353llu;
+    z[3] ^= e & 0xB2B2B2B2B2B2B2B2llu;
+    z[4] ^= e & 0x7D7D7D7D7D7D7D7Dllu;
+    z[5] ^= e & 0x5656565656565656llu;
+    z[6] ^= e & 0x6464646464646464llu;
+    z[7] ^= e & 0x3636363636363636llu;
+    e = (y[5] >> 1) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x3636363636363636llu;
+    z[1] ^= e & 0x5252525252525252llu;
+    z[2] ^= e & 0x3434343434343434llu;
+    z[3] ^= e & 0x6565656565656565llu;
+    z[4] ^= e & 0x8484848484848484llu;
+    z[5] ^= e & 0x7D7D7D7D7D7D7D7Dllu;
+    z[6] ^= e & 0x5656565656565656llu;
+    z[7] ^= e & 0x6464646464646464llu;
+    e = (y[6] >> 1) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x6464646464646464llu;
+    z[1] ^= e & 0x3636363636363636llu;
+    z[2] ^= e & 0x3636363636363636llu;
+    z[3] ^= e & 0x5050505050505050llu;
+    z[4] ^= e & 0x0101010101010101llu;
+    z[5] ^= e & 0x8484848484848484llu;
+    z[6] ^= e & 0x7D7D7D7D7D7D7D7Dllu;
+    z[7] ^= e & 0x5656565656565656llu;
+    e = (y[7] >> 1) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x5656565656565656llu;
+    z[1] ^= e & 0x6464646464646464llu;
+    z[2] ^= e & 0x6060606060606060llu;
+    z[3] ^= e & 0x6060606060606060llu;
+    z[4] ^= e & 0x0606060606060606llu;
+    z[5] ^= e & 0x0101010101010101llu;
+    z[6] ^= e & 0x8484848484848484llu;
+    z[7] ^= e & 0x7D7D7D7D7D7D7D7Dllu;
+    e = (y[0] >> 2) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x4848484848484848llu;
+    z[1] ^= e & 0x3030303030303030llu;
+    z[2] ^= e & 0x0707070707070707llu;
+    z[3] ^= e & 0x6F6F6F6F6F6F6F6Fllu;
+    z[4] ^= e & 0x9494949494949494llu;
+    z[5] ^= e & 0x1919191919191919llu;
+    z[6] ^= e & 0x8282828282828282llu;
+    z[7] ^= e & 0x6F6F6F6F6F6F6F6Fllu;
+    e = (y[1] >> 2) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x6F6F6F6F6F6F6F6Fllu;
+    z[1] ^= e & 0x4848484848484848llu;
+    z[2] ^= e & 0x5F5F5F5F5F5F5F5Fllu;
+    z[3] ^= e & 0x6868686868686868llu;
+    z[5] ^= e & 0x9494949494949494llu;
+    z[6] ^= e & 0x1919191919191919llu;
+    z[7] ^= e & 0x8282828282828282llu;
+    e = (y[2] >> 2) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x8282828282828282llu;
+    z[1] ^= e & 0x6F6F6F6F6F6F6F6Fllu;
+    z[2] ^= e & 0xCACACACACACACACAllu;
+    z[3] ^= e & 0xDDDDDDDDDDDDDDDDllu;
+    z[4] ^= e & 0xEAEAEAEAEAEAEAEAllu;
+    z[6] ^= e & 0x9494949494949494llu;
+    z[7] ^= e & 0x1919191919191919llu;
+    e = (y[3] >> 2) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x1919191919191919llu;
+    z[1] ^= e & 0x8282828282828282llu;
+    z[2] ^= e & 0x7676767676767676llu;
+    z[3] ^= e & 0xD3D3D3D3D3D3D3D3llu;
+    z[4] ^= e & 0xC4C4C4C4C4C4C4C4llu;
+    z[5] ^= e & 0xEAEAEAEAEAEAEAEAllu;
+    z[7] ^= e & 0x9494949494949494llu;
+    e = (y[4] >> 2) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x9494949494949494llu;
+    z[1] ^= e & 0x1919191919191919llu;
+    z[2] ^= e & 0x1616161616161616llu;
+    z[3] ^= e & 0xE2E2E2E2E2E2E2E2llu;
+    z[4] ^= e & 0x4747474747474747llu;
+    z[5] ^= e & 0xC4C4C4C4C4C4C4C4llu;
+    z[6] ^= e & 0xEAEAEAEAEAEAEAEAllu;
+    e = (y[5] >> 2) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[1] ^= e & 0x9494949494949494llu;
+    z[2] ^= e & 0x1919191919191919llu;
+    z[3] ^= e & 0x1616161616161616llu;
+    z[4] ^= e & 0xE2E2E2E2E2E2E2E2llu;
+    z[5] ^= e & 0x4747474747474747llu;
+    z[6] ^= e & 0xC4C4C4C4C4C4C4C4llu;
+    z[7] ^= e & 0xEAEAEAEAEAEAEAEAllu;
+    e = (y[6] >> 2) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xEAEAEAEAEAEAEAEAllu;
+    z[2] ^= e & 0x7E7E7E7E7E7E7E7Ellu;
+    z[3] ^= e & 0xF3F3F3F3F3F3F3F3llu;
+    z[4] ^= e & 0xFCFCFCFCFCFCFCFCllu;
+    z[5] ^= e & 0xE2E2E2E2E2E2E2E2llu;
+    z[6] ^= e & 0x4747474747474747llu;
+    z[7] ^= e & 0xC4C4C4C4C4C4C4C4llu;
+    e = (y[7] >> 2) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xC4C4C4C4C4C4C4C4llu;
+    z[1] ^= e & 0xEAEAEAEAEAEAEAEAllu;
+    z[2] ^= e & 0xC4C4C4C4C4C4C4C4llu;
+    z[3] ^= e & 0xBABABABABABABABAllu;
+    z[4] ^= e & 0x3737373737373737llu;
+    z[5] ^= e & 0xFCFCFCFCFCFCFCFCllu;
+    z[6] ^= e & 0xE2E2E2E2E2E2E2E2llu;
+    z[7] ^= e & 0x4747474747474747llu;
+    e = (y[0] >> 3) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x6767676767676767llu;
+    z[1] ^= e & 0x3131313131313131llu;
+    z[2] ^= e & 0x0C0C0C0C0C0C0C0Cllu;
+    z[3] ^= e & 0x9898989898989898llu;
+    z[4] ^= e & 0xB0B0B0B0B0B0B0B0llu;
+    z[5] ^= e & 0x9696969696969696llu;
+    z[6] ^= e & 0x4444444444444444llu;
+    z[7] ^= e & 0x7878787878787878llu;
+    e = (y[1] >> 3) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x7878787878787878llu;
+    z[1] ^= e & 0x6767676767676767llu;
+    z[2] ^= e & 0x4949494949494949llu;
+    z[3] ^= e & 0x7474747474747474llu;
+    z[4] ^= e & 0xE0E0E0E0E0E0E0E0llu;
+    z[5] ^= e & 0xB0B0B0B0B0B0B0B0llu;
+    z[6] ^= e & 0x9696969696969696llu;
+    z[7] ^= e & 0x4444444444444444llu;
+    e = (y[2] >> 3) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x4444444444444444llu;
+    z[1] ^= e & 0x7878787878787878llu;
+    z[2] ^= e & 0x2323232323232323llu;
+    z[3] ^= e & 0x0D0D0D0D0D0D0D0Dllu;
+    z[4] ^= e & 0x3030303030303030llu;
+    z[5] ^= e & 0xE0E0E0E0E0E0E0E0llu;
+    z[6] ^= e & 0xB0B0B0B0B0B0B0B0llu;
+    z[7] ^= e & 0x9696969696969696llu;
+    e = (y[3] >> 3) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x9696969696969696llu;
+    z[1] ^= e & 0x4444444444444444llu;
+    z[2] ^= e & 0xEEEEEEEEEEEEEEEEllu;
+    z[3] ^= e & 0xB5B5B5B5B5B5B5B5llu;
+    z[4] ^= e & 0x9B9B9B9B9B9B9B9Bllu;
+    z[5] ^= e & 0x3030303030303030llu;
+    z[6] ^= e & 0xE0E0E0E0E0E0E0E0llu;
+    z[7] ^= e & 0xB0B0B0B0B0B0B0B0llu;
+    e = (y[4] >> 3) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xB0B0B0B0B0B0B0B0llu;
+    z[1] ^= e & 0x9696969696969696llu;
+    z[2] ^= e & 0xF4F4F4F4F4F4F4F4llu;
+    z[3] ^= e & 0x5E5E5E5E5E5E5E5Ellu;
+    z[4] ^= e & 0x0505050505050505llu;
+    z[5] ^= e & 0x9B9B9B9B9B9B9B9Bllu;
+    z[6] ^= e & 0x3030303030303030llu;
+    z[7] ^= e & 0xE0E0E0E0E0E0E0E0llu;
+    e = (y[5] >> 3) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xE0E0E0E0E0E0E0E0llu;
+    z[1] ^= e & 0xB0B0B0B0B0B0B0B0llu;
+    z[2] ^= e & 0x7676767676767676llu;
+    z[3] ^= e & 0x1414141414141414llu;
+    z[4] ^= e & 0xBEBEBEBEBEBEBEBEllu;
+    z[5] ^= e & 0x0505050505050505llu;
+    z[6] ^= e & 0x9B9B9B9B9B9B9B9Bllu;
+    z[7] ^= e & 0x3030303030303030llu;
+    e = (y[6] >> 3) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x3030303030303030llu;
+    z[1] ^= e & 0xE0E0E0E0E0E0E0E0llu;
+    z[2] ^= e & 0x8080808080808080llu;
+    z[3] ^= e & 0x4646464646464646llu;
+    z[4] ^= e & 0x2424242424242424llu;
+    z[5] ^= e & 0xBEBEBEBEBEBEBEBEllu;
+    z[6] ^= e & 0x0505050505050505llu;
+    z[7] ^= e & 0x9B9B9B9B9B9B9B9Bllu;
+    e = (y[7] >> 3) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x9B9B9B9B9B9B9B9Bllu;
+    z[1] ^= e & 0x3030303030303030llu;
+    z[2] ^= e & 0x7B7B7B7B7B7B7B7Bllu;
+    z[3] ^= e & 0x1B1B1B1B1B1B1B1Bllu;
+    z[4] ^= e & 0xDDDDDDDDDDDDDDDDllu;
+    z[5] ^= e & 0x2424242424242424llu;
+    z[6] ^= e & 0xBEBEBEBEBEBEBEBEllu;
+    z[7] ^= e & 0x0505050505050505llu;
+    e = (y[0] >> 4) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x0909090909090909llu;
+    z[1] ^= e & 0x8383838383838383llu;
+    z[2] ^= e & 0x8E8E8E8E8E8E8E8Ellu;
+    z[3] ^= e & 0xD5D5D5D5D5D5D5D5llu;
+    z[4] ^= e & 0xB1B1B1B1B1B1B1B1llu;
+    z[5] ^= e & 0x4848484848484848llu;
+    z[6] ^= e & 0x0909090909090909llu;
+    z[7] ^= e & 0xC4C4C4C4C4C4C4C4llu;
+    e = (y[1] >> 4) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xC4C4C4C4C4C4C4C4llu;
+    z[1] ^= e & 0x0909090909090909llu;
+    z[2] ^= e & 0x4747474747474747llu;
+    z[3] ^= e & 0x4A4A4A4A4A4A4A4Allu;
+    z[4] ^= e & 0x1111111111111111llu;
+    z[5] ^= e & 0xB1B1B1B1B1B1B1B1llu;
+    z[6] ^= e & 0x4848484848484848llu;
+    z[7] ^= e & 0x0909090909090909llu;
+    e = (y[2] >> 4) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x0909090909090909llu;
+    z[1] ^= e & 0xC4C4C4C4C4C4C4C4llu;
+    z[3] ^= e & 0x4E4E4E4E4E4E4E4Ellu;
+    z[4] ^= e & 0x4343434343434343llu;
+    z[5] ^= e & 0x1111111111111111llu;
+    z[6] ^= e & 0xB1B1B1B1B1B1B1B1llu;
+    z[7] ^= e & 0x4848484848484848llu;
+    e = (y[3] >> 4) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x4848484848484848llu;
+    z[1] ^= e & 0x0909090909090909llu;
+    z[2] ^= e & 0x8C8C8C8C8C8C8C8Cllu;
+    z[3] ^= e & 0x4848484848484848llu;
+    z[4] ^= e & 0x0606060606060606llu;
+    z[5] ^= e & 0x4343434343434343llu;
+    z[6] ^= e & 0x1111111111111111llu;
+    z[7] ^= e & 0xB1B1B1B1B1B1B1B1llu;
+    e = (y[4] >> 4) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xB1B1B1B1B1B1B1B1llu;
+    z[1] ^= e & 0x4848484848484848llu;
+    z[2] ^= e & 0xB8B8B8B8B8B8B8B8llu;
+    z[3] ^= e & 0x3D3D3D3D3D3D3D3Dllu;
+    z[4] ^= e & 0xF9F9F9F9F9F9F9F9llu;
+    z[5] ^= e & 0x0606060606060606llu;
+    z[6] ^= e & 0x4343434343434343llu;
+    z[7] ^= e & 0x1111111111111111llu;
+    e = (y[5] >> 4) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x1111111111111111llu;
+    z[1] ^= e & 0xB1B1B1B1B1B1B1B1llu;
+    z[2] ^= e & 0x5959595959595959llu;
+    z[3] ^= e & 0xA9A9A9A9A9A9A9A9llu;
+    z[4] ^= e & 0x2C2C2C2C2C2C2C2Cllu;
+    z[5] ^= e & 0xF9F9F9F9F9F9F9F9llu;
+    z[6] ^= e & 0x0606060606060606llu;
+    z[7] ^= e & 0x4343434343434343llu;
+    e = (y[6] >> 4) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x4343434343434343llu;
+    z[1] ^= e & 0x1111111111111111llu;
+    z[2] ^= e & 0xF2F2F2F2F2F2F2F2llu;
+    z[3] ^= e & 0x1A1A1A1A1A1A1A1Allu;
+    z[4] ^= e & 0xEAEAEAEAEAEAEAEAllu;
+    z[5] ^= e & 0x2C2C2C2C2C2C2C2Cllu;
+    z[6] ^= e & 0xF9F9F9F9F9F9F9F9llu;
+    z[7] ^= e & 0x0606060606060606llu;
+    e = (y[7] >> 4) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x0606060606060606llu;
+    z[1] ^= e & 0x4343434343434343llu;
+    z[2] ^= e & 0x1717171717171717llu;
+    z[3] ^= e & 0xF4F4F4F4F4F4F4F4llu;
+    z[4] ^= e & 0x1C1C1C1C1C1C1C1Cllu;
+    z[5] ^= e & 0xEAEAEAEAEAEAEAEAllu;
+    z[6] ^= e & 0x2C2C2C2C2C2C2C2Cllu;
+    z[7] ^= e & 0xF9F9F9F9F9F9F9F9llu;
+    e = (y[0] >> 5) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x4B4B4B4B4B4B4B4Bllu;
+    z[1] ^= e & 0x7474747474747474llu;
+    z[2] ^= e & 0x4646464646464646llu;
+    z[3] ^= e & 0x9B9B9B9B9B9B9B9Bllu;
+    z[4] ^= e & 0x6B6B6B6B6B6B6B6Bllu;
+    z[5] ^= e & 0xE3E3E3E3E3E3E3E3llu;
+    z[6] ^= e & 0x4B4B4B4B4B4B4B4Bllu;
+    z[7] ^= e & 0x1D1D1D1D1D1D1D1Dllu;
+    e = (y[1] >> 5) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x1D1D1D1D1D1D1D1Dllu;
+    z[1] ^= e & 0x4B4B4B4B4B4B4B4Bllu;
+    z[2] ^= e & 0x6969696969696969llu;
+    z[3] ^= e & 0x5B5B5B5B5B5B5B5Bllu;
+    z[4] ^= e & 0x8686868686868686llu;
+    z[5] ^= e & 0x6B6B6B6B6B6B6B6Bllu;
+    z[6] ^= e & 0xE3E3E3E3E3E3E3E3llu;
+    z[7] ^= e & 0x4B4B4B4B4B4B4B4Bllu;
+    e = (y[2] >> 5) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x4B4B4B4B4B4B4B4Bllu;
+    z[1] ^= e & 0x1D1D1D1D1D1D1D1Dllu;
+    z[3] ^= e & 0x2222222222222222llu;
+    z[4] ^= e & 0x1010101010101010llu;
+    z[5] ^= e & 0x8686868686868686llu;
+    z[6] ^= e & 0x6B6B6B6B6B6B6B6Bllu;
+    z[7] ^= e & 0xE3E3E3E3E3E3E3E3llu;
+    e = (y[3] >> 5) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xE3E3E3E3E3E3E3E3llu;
+    z[1] ^= e & 0x4B4B4B4B4B4B4B4Bllu;
+    z[2] ^= e & 0xFEFEFEFEFEFEFEFEllu;
+    z[3] ^= e & 0xE3E3E3E3E3E3E3E3llu;
+    z[4] ^= e & 0xC1C1C1C1C1C1C1C1llu;
+    z[5] ^= e & 0x1010101010101010llu;
+    z[6] ^= e & 0x8686868686868686llu;
+    z[7] ^= e & 0x6B6B6B6B6B6B6B6Bllu;
+    e = (y[4] >> 5) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x6B6B6B6B6B6B6B6Bllu;
+    z[1] ^= e & 0xE3E3E3E3E3E3E3E3llu;
+    z[2] ^= e & 0x2020202020202020llu;
+    z[3] ^= e & 0x9595959595959595llu;
+    z[4] ^= e & 0x8888888888888888llu;
+    z[5] ^= e & 0xC1C1C1C1C1C1C1C1llu;
+    z[6] ^= e & 0x1010101010101010llu;
+    z[7] ^= e & 0x8686868686868686llu;
+    e = (y[5] >> 5) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x8686868686868686llu;
+    z[1] ^= e & 0x6B6B6B6B6B6B6B6Bllu;
+    z[2] ^= e & 0x6565656565656565llu;
+    z[3] ^= e & 0xA6A6A6A6A6A6A6A6llu;
+    z[4] ^= e & 0x1313131313131313llu;
+    z[5] ^= e & 0x8888888888888888llu;
+    z[6] ^= e & 0xC1C1C1C1C1C1C1C1llu;
+    z[7] ^= e & 0x1010101010101010llu;
+    e = (y[6] >> 5) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x1010101010101010llu;
+    z[1] ^= e & 0x8686868686868686llu;
+    z[2] ^= e & 0x7B7B7B7B7B7B7B7Bllu;
+    z[3] ^= e & 0x7575757575757575llu;
+    z[4] ^= e & 0xB6B6B6B6B6B6B6B6llu;
+    z[5] ^= e & 0x1313131313131313llu;
+    z[6] ^= e & 0x8888888888888888llu;
+    z[7] ^= e & 0xC1C1C1C1C1C1C1C1llu;
+    e = (y[7] >> 5) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xC1C1C1C1C1C1C1C1llu;
+    z[1] ^= e & 0x1010101010101010llu;
+    z[2] ^= e & 0x4747474747474747llu;
+    z[3] ^= e & 0xBABABABABABABABAllu;
+    z[4] ^= e & 0xB4B4B4B4B4B4B4B4llu;
+    z[5] ^= e & 0xB6B6B6B6B6B6B6B6llu;
+    z[6] ^= e & 0x1313131313131313llu;
+    z[7] ^= e & 0x8888888888888888llu;
+    e = (y[0] >> 6) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x2E2E2E2E2E2E2E2Ellu;
+    z[1] ^= e & 0x1E1E1E1E1E1E1E1Ellu;
+    z[2] ^= e & 0x7D7D7D7D7D7D7D7Dllu;
+    z[3] ^= e & 0xDADADADADADADADAllu;
+    z[4] ^= e & 0xF0F0F0F0F0F0F0F0llu;
+    z[5] ^= e & 0x2121212121212121llu;
+    z[6] ^= e & 0x6C6C6C6C6C6C6C6Cllu;
+    z[7] ^= e & 0x7373737373737373llu;
+    e = (y[1] >> 6) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x7373737373737373llu;
+    z[1] ^= e & 0x2E2E2E2E2E2E2E2Ellu;
+    z[2] ^= e & 0x6D6D6D6D6D6D6D6Dllu;
+    z[3] ^= e & 0x0E0E0E0E0E0E0E0Ellu;
+    z[4] ^= e & 0xA9A9A9A9A9A9A9A9llu;
+    z[5] ^= e & 0xF0F0F0F0F0F0F0F0llu;
+    z[6] ^= e & 0x2121212121212121llu;
+    z[7] ^= e & 0x6C6C6C6C6C6C6C6Cllu;
+    e = (y[2] >> 6) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x6C6C6C6C6C6C6C6Cllu;
+    z[1] ^= e & 0x7373737373737373llu;
+    z[2] ^= e & 0x4242424242424242llu;
+    z[3] ^= e & 0x0101010101010101llu;
+    z[4] ^= e & 0x6262626262626262llu;
+    z[5] ^= e & 0xA9A9A9A9A9A9A9A9llu;
+    z[6] ^= e & 0xF0F0F0F0F0F0F0F0llu;
+    z[7] ^= e & 0x2121212121212121llu;
+    e = (y[3] >> 6) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x2121212121212121llu;
+    z[1] ^= e & 0x6C6C6C6C6C6C6C6Cllu;
+    z[2] ^= e & 0x5252525252525252llu;
+    z[3] ^= e & 0x6363636363636363llu;
+    z[4] ^= e & 0x2020202020202020llu;
+    z[5] ^= e & 0x6262626262626262llu;
+    z[6] ^= e & 0xA9A9A9A9A9A9A9A9llu;
+    z[7] ^= e & 0xF0F0F0F0F0F0F0F0llu;
+    e = (y[4] >> 6) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xF0F0F0F0F0F0F0F0llu;
+    z[1] ^= e & 0x2121212121212121llu;
+    z[2] ^= e & 0x9C9C9C9C9C9C9C9Cllu;
+    z[3] ^= e & 0xA2A2A2A2A2A2A2A2llu;
+    z[4] ^= e & 0x9393939393939393llu;
+    z[5] ^= e & 0x2020202020202020llu;
+    z[6] ^= e & 0x6262626262626262llu;
+    z[7] ^= e & 0xA9A9A9A9A9A9A9A9llu;
+    e = (y[5] >> 6) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xA9A9A9A9A9A9A9A9llu;
+    z[1] ^= e & 0xF0F0F0F0F0F0F0F0llu;
+    z[2] ^= e & 0x8888888888888888llu;
+    z[3] ^= e & 0x3535353535353535llu;
+    z[4] ^= e & 0x0B0B0B0B0B0B0B0Bllu;
+    z[5] ^= e & 0x9393939393939393llu;
+    z[6] ^= e & 0x2020202020202020llu;
+    z[7] ^= e & 0x6262626262626262llu;
+    e = (y[6] >> 6) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x6262626262626262llu;
+    z[1] ^= e & 0xA9A9A9A9A9A9A9A9llu;
+    z[2] ^= e & 0x9292929292929292llu;
+    z[3] ^= e & 0xEAEAEAEAEAEAEAEAllu;
+    z[4] ^= e & 0x5757575757575757llu;
+    z[5] ^= e & 0x0B0B0B0B0B0B0B0Bllu;
+    z[6] ^= e & 0x9393939393939393llu;
+    z[7] ^= e & 0x2020202020202020llu;
+    e = (y[7] >> 6) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x2020202020202020llu;
+    z[1] ^= e & 0x6262626262626262llu;
+    z[2] ^= e & 0x8989898989898989llu;
+    z[3] ^= e & 0xB2B2B2B2B2B2B2B2llu;
+    z[4] ^= e & 0xCACACACACACACACAllu;
+    z[5] ^= e & 0x5757575757575757llu;
+    z[6] ^= e & 0x0B0B0B0B0B0B0B0Bllu;
+    z[7] ^= e & 0x9393939393939393llu;
+    e = (y[0] >> 7) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x9C9C9C9C9C9C9C9Cllu;
+    z[1] ^= e & 0xB8B8B8B8B8B8B8B8llu;
+    z[2] ^= e & 0x2323232323232323llu;
+    z[3] ^= e & 0x3A3A3A3A3A3A3A3Allu;
+    z[4] ^= e & 0x0606060606060606llu;
+    z[5] ^= e & 0x5555555555555555llu;
+    z[6] ^= e & 0x4949494949494949llu;
+    z[7] ^= e & 0xE0E0E0E0E0E0E0E0llu;
+    e = (y[1] >> 7) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xE0E0E0E0E0E0E0E0llu;
+    z[1] ^= e & 0x9C9C9C9C9C9C9C9Cllu;
+    z[2] ^= e & 0x5858585858585858llu;
+    z[3] ^= e & 0xC3C3C3C3C3C3C3C3llu;
+    z[4] ^= e & 0xDADADADADADADADAllu;
+    z[5] ^= e & 0x0606060606060606llu;
+    z[6] ^= e & 0x5555555555555555llu;
+    z[7] ^= e & 0x4949494949494949llu;
+    e = (y[2] >> 7) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x4949494949494949llu;
+    z[1] ^= e & 0xE0E0E0E0E0E0E0E0llu;
+    z[2] ^= e & 0xD5D5D5D5D5D5D5D5llu;
+    z[3] ^= e & 0x1111111111111111llu;
+    z[4] ^= e & 0x8A8A8A8A8A8A8A8Allu;
+    z[5] ^= e & 0xDADADADADADADADAllu;
+    z[6] ^= e & 0x0606060606060606llu;
+    z[7] ^= e & 0x5555555555555555llu;
+    e = (y[3] >> 7) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x5555555555555555llu;
+    z[1] ^= e & 0x4949494949494949llu;
+    z[2] ^= e & 0xB5B5B5B5B5B5B5B5llu;
+    z[3] ^= e & 0x8080808080808080llu;
+    z[4] ^= e & 0x4444444444444444llu;
+    z[5] ^= e & 0x8A8A8A8A8A8A8A8Allu;
+    z[6] ^= e & 0xDADADADADADADADAllu;
+    z[7] ^= e & 0x0606060606060606llu;
+    e = (y[4] >> 7) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x0606060606060606llu;
+    z[1] ^= e & 0x5555555555555555llu;
+    z[2] ^= e & 0x4F4F4F4F4F4F4F4Fllu;
+    z[3] ^= e & 0xB3B3B3B3B3B3B3B3llu;
+    z[4] ^= e & 0x8686868686868686llu;
+    z[5] ^= e & 0x4444444444444444llu;
+    z[6] ^= e & 0x8A8A8A8A8A8A8A8Allu;
+    z[7] ^= e & 0xDADADADADADADADAllu;
+    e = (y[5] >> 7) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0xDADADADADADADADAllu;
+    z[1] ^= e & 0x0606060606060606llu;
+    z[2] ^= e & 0x8F8F8F8F8F8F8F8Fllu;
+    z[3] ^= e & 0x9595959595959595llu;
+    z[4] ^= e & 0x6969696969696969llu;
+    z[5] ^= e & 0x8686868686868686llu;
+    z[6] ^= e & 0x4444444444444444llu;
+    z[7] ^= e & 0x8A8A8A8A8A8A8A8Allu;
+    e = (y[6] >> 7) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x8A8A8A8A8A8A8A8Allu;
+    z[1] ^= e & 0xDADADADADADADADAllu;
+    z[2] ^= e & 0x8C8C8C8C8C8C8C8Cllu;
+    z[3] ^= e & 0x0505050505050505llu;
+    z[4] ^= e & 0x1F1F1F1F1F1F1F1Fllu;
+    z[5] ^= e & 0x6969696969696969llu;
+    z[6] ^= e & 0x8686868686868686llu;
+    z[7] ^= e & 0x4444444444444444llu;
+    e = (y[7] >> 7) & 0x0101010101010101llu;
+    e = (e << 8) - e;
+    z[0] ^= e & 0x4444444444444444llu;
+    z[1] ^= e & 0x8A8A8A8A8A8A8A8Allu;
+    z[2] ^= e & 0x9E9E9E9E9E9E9E9Ellu;
+    z[3] ^= e & 0xC8C8C8C8C8C8C8C8llu;
+    z[4] ^= e & 0x4141414141414141llu;
+    z[5] ^= e & 0x1F1F1F1F1F1F1F1Fllu;
+    z[6] ^= e & 0x6969696969696969llu;
+    z[7] ^= e & 0x8686868686868686llu;
+}
+
+// x = LPS(x)
+
+static inline void SBOB_BS(lps)(SBOB_BS_T x[8])
+{
+    int i;
+    SBOB_BS_T y[8];
+
+    SBOB_BS(sbox)(x);
+    for (i = 0; i < 8; i++)
+        SBOB_BS(tr8)(&y[i], &x[i]);
+    SBOB_BS(lin)(x, y);
+}
@@ -0,0 +1,346 @@
+#!/usr/bin/env python3
+# sbob_bs_gen.py
+# 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+#              See LICENSE for Licensing and Warranty information.
+
+# Generator for the bitsliced backend. Reads sbob_sl64 and sbob_rc64 from
+# sbob_tab64.c and writes sbob_bs.h, or with "rc" the sbob_bs_rc table of
+# sbob_pi_bs.c, to stdout:
+#
+#   python3 sbob_bs_gen.py > sbob_bs.h
+#   python3 sbob_bs_gen.py rc
+#
+# Each row of sbob_sl64 is L(pi(v)) for a linear L; this is checked for
+# the GOST R 34.11-2012 S-box pi below. The S-box circuit is the
+# algebraic normal form of each output bit: the monomials are built
+# from products of smaller ones, and the XORs shared by several outputs
+# are found greedily (most frequent pair first). The linear layer uses
+# the images of the unit vectors under L.
+
+import re
+import sys
+
+PI = [
+    252, 238, 221,  17, 207, 110,  49,  22, 251, 196, 250, 218,
+     35, 197,   4,  77, 233, 119, 240, 219, 147,  46, 153, 186,
+     23,  54, 241, 187,  20, 205,  95, 193, 249,  24, 101,  90,
+    226,  92, 239,  33, 129,  28,  60,  66, 139,   1, 142,  79,
+      5, 132,   2, 174, 227, 106, 143, 160,   6,  11, 237, 152,
+    127, 212, 211,  31, 235,  52,  44,  81, 234, 200,  72, 171,
+    242,  42, 104, 162, 253,  58, 206, 204, 181, 112,  14,  86,
+      8,  12, 118,  18, 191, 114,  19,  71, 156, 183,  93, 135,
+     21, 161, 150,  41,  16, 123, 154, 199, 243, 145, 120, 111,
+    157, 158, 178, 177,  50, 117,  25,  61, 255,  53, 138, 126,
+    109,  84, 198, 128, 195, 189,  13,  87, 223, 245,  36, 169,
+     62, 168,  67, 201, 215, 121, 214, 246, 124,  34, 185,   3,
+    224,  15, 236, 222, 122, 148, 176, 188, 220, 232,  40,  80,
+     78,  51,  10,  74, 167, 151,  96, 115,  30,   0,  98,  68,
+     26, 184,  56, 130, 100, 159,  38,  65, 173,  69,  70, 146,
+     39,  94,  85,  47, 140, 163, 165, 125, 105, 213, 149,  59,
+      7,  88, 179,  64, 134, 172,  29, 247,  48,  55, 107, 228,
+    136, 217, 231, 137, 225,  27, 131,  73,  76,  63, 248, 254,
+    141,  83, 170, 144, 202, 216, 133,  97,  32, 113, 103, 164,
+     45,  43,   9,  91, 203, 155,  37, 208, 190, 229, 108,  82,
+     89, 166, 116, 210, 230, 244, 180, 192, 209, 102, 175, 194,
+     57,  75,  99, 182
+]
+
+# tables of sbob_tab64.c, as the uint64_t values in memory (xT64 swaps
+# the byte order of the constants on little-endian machines)
+
+def load_tables(fn):
+    src = open(fn).read()
+    vals = [int(x, 16) for x in
+            re.findall(r'xT64\(0x([0-9A-Fa-f]{16})\)', src)]
+    assert len(vals) == 8 * 256 + 12 * 8
+    vals = [int.from_bytes(x.to_bytes(8, 'big'), 'little') for x in vals]
+    sl = [vals[256 * j:256 * (j + 1)] for j in range(8)]
+    rc = [vals[2048 + 8 * r:2048 + 8 * (r + 1)] for r in range(12)]
+    return sl, rc
+
+# L images of the unit vectors; sl[j][v] == XOR of lmat[j][b], pi[v] bit b
+
+def lin_layer(sl):
+    ipi = [0] * 256
+    for x in range(256):
+        ipi[PI[x]] = x
+    lmat = [[sl[j][ipi[1 << b]] for b in range(8)] for j in range(8)]
+    for j in range(8):
+        for v in range(256):
+            acc = 0
+            for b in range(8):
+                if PI[v] >> b & 1:
+                    acc ^= lmat[j][b]
+            assert acc == sl[j][v], "sbob_sl64 is not L(pi)"
+    return lmat
+
+# S-box circuit: ANF monomials and shared XORs
+
+def sbox_circuit():
+    anf = []
+    for b in range(8):
+        a = [(PI[x] >> b) & 1 for x in range(256)]
+        for i in range(8):
+            for x in range(256):
+                if x >> i & 1:
+                    a[x] ^= a[x ^ (1 << i)]
+        anf.append(set(m for m in range(256) if a[m]))
+    mons = set().union(*anf)
+    const = [0 in s for s in anf]
+    rows = [set(s) - {0} for s in anf]
+
+    # pairs of terms shared by at least two outputs
+    nxt = 256
+    newvars = {}
+    while True:
+        cnt = {}
+        for r in rows:
+            t = sorted(r)
+            for i in range(len(t)):
+                for j in range(i + 1, len(t)):
+                    cnt[(t[i], t[j])] = cnt.get((t[i], t[j]), 0) + 1
+        best = max(cnt.items(), key=lambda kv: kv[1]) if cnt else None
+        if not best or best[1] < 2:
+            break
+        (a, b), c = best
+        newvars[nxt] = (a, b)
+        for r in rows:
+            if a in r and b in r:
+                r.discard(a)
+                r.discard(b)
+                r.add(nxt)
+        nxt += 1
+
+    # every monomial is a smaller one times its lowest variable
+    needed = set()
+    for m in sorted(mons):
+        while m and (m & (m - 1)):
+            needed.add(m)
+            m &= m - 1
+    return const, rows, newvars, needed
+
+def gen_sbox(out):
+    w = out.append
+    const, rows, newvars, needed = sbox_circuit()
+    names = {}
+    for b in range(8):
+        names[1 << b] = "x[%d]" % b
+
+    lines = []
+    decl = []
+    for m in sorted(needed):
+        lo = m & -m
+        names[m] = "p%02x" % m
+        lines.append("    p%02x = %s & %s;" % (m, names[m ^ lo], names[lo]))
+        decl.append("p%02x" % m)
+    for v, (a, b) in newvars.items():
+        names[v] = "q%d" % (v - 256)
+        lines.append("    q%d = %s ^ %s;" % (v - 256, names[a], names[b]))
+        decl.append("q%d" % (v - 256))
+    decl += ["y%d" % b for b in range(8)]
+
+    w("// S-box as a Boolean circuit: algebraic normal form of each "
+      "output bit")
+    w("// with shared subexpressions. x[b] holds bit b of all 64 state bytes.")
+    w("")
+    w("static inline void SBOB_BS(sbox)(SBOB_BS_T x[8])")
+    w("{")
+    cur = "    SBOB_BS_T"
+    for i, n in enumerate(decl):
+        piece = " %s%s" % (n, ";" if i == len(decl) - 1 else ",")
+        if len(cur) + len(piece) > 76:
+            out.append(cur)
+            cur = "       "
+        cur += piece
+    out.append(cur)
+    w("")
+    out.extend(lines)
+    w("")
+    for b in range(8):
+        e = " ^ ".join(names[t] for t in sorted(rows[b]) if t != 0)
+        if const[b]:
+            e = "~(%s)" % e
+        parts = ("    y%d = %s;" % (b, e)).split(" ^ ")
+        cur = parts[0]
+        for p in parts[1:]:
+            if len(cur) + len(p) + 3 > 76:
+                out.append(cur + " ^")
+                cur = "        " + p
+            else:
+                cur += " ^ " + p
+        out.append(cur)
+    w("")
+    for b in range(8):
+        w("    x[%d] = y%d;" % (b, b))
+    w("}")
+
+def gen_lin(out, lmat):
+    w = out.append
+    w("// P and L: y has been transposed so that bit j of byte i of y[b] "
+      "is bit b")
+    w("// of the S-box output at row j, column i. Each (j, b) selects "
+      "a row of L.")
+    w("")
+    w("static inline void SBOB_BS(lin)(SBOB_BS_T z[8], const SBOB_BS_T y[8])")
+    w("{")
+    w("    SBOB_BS_T e;")
+    w("")
+    first = [True] * 8
+    for j in range(8):
+        for b in range(8):
+            if j:
+                w("    e = (y[%d] >> %d) & 0x0101010101010101llu;" % (b, j))
+            else:
+                w("    e = y[%d] & 0x0101010101010101llu;" % b)
+            w("    e = (e << 8) - e;")
+            for bp in range(8):
+                cb = 0
+                for c in range(8):
+                    if lmat[j][b] >> (8 * c + bp) & 1:
+                        cb |= 1 << c
+                k = cb * 0x0101010101010101
+                if first[bp]:
+                    if cb == 0:
+                        w("    z[%d] = e & 0;" % bp)
+                    elif cb == 0xFF:
+                        w("    z[%d] = e;" % bp)
+                    else:
+                        w("    z[%d] = e & 0x%016Xllu;" % (bp, k))
+                    first[bp] = False
+                elif cb == 0xFF:
+                    w("    z[%d] ^= e;" % bp)
+                elif cb != 0:
+                    w("    z[%d] ^= e & 0x%016Xllu;" % (bp, k))
+    w("}")
+
+HEAD = """// sbob_bs.h
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Bitsliced LPS transform, included by sbob_pi_bs.c once for each word
+// type SBOB_BS_T (with function names SBOB_BS(name)). A state is held as
+// eight bit planes: bit 8 * j + i of x[b] is bit b of byte i of word j.
+// There are no table lookups; the S-box and L are computed with logic.
+//
+// Generated by sbob_bs_gen.py from the tables of sbob_tab64.c; edit
+// that script rather than this file.
+
+// 8 x 8 bit matrix transpose within each 64-bit word
+
+static inline void SBOB_BS(tr8)(SBOB_BS_T *y, const SBOB_BS_T *x)
+{
+    SBOB_BS_T a, t;
+
+    a = *x;
+    t = (a ^ (a >> 7)) & 0x00AA00AA00AA00AAllu;
+    a = a ^ t ^ (t << 7);
+    t = (a ^ (a >> 14)) & 0x0000CCCC0000CCCCllu;
+    a = a ^ t ^ (t << 14);
+    t = (a ^ (a >> 28)) & 0x00000000F0F0F0F0llu;
+    *y = a ^ t ^ (t << 28);
+}
+
+// 8 x 8 byte matrix transpose across eight words
+
+static inline void SBOB_BS(trb)(SBOB_BS_T x[8])
+{
+    int i, j;
+    SBOB_BS_T a, b;
+
+    for (i = 0; i < 4; i++) {
+        a = x[i];
+        b = x[i + 4];
+        x[i] = (a & 0x00000000FFFFFFFFllu) | (b << 32);
+        x[i + 4] = (a >> 32) | (b & 0xFFFFFFFF00000000llu);
+    }
+    for (j = 0; j < 8; j += 4) {
+        for (i = j; i < j + 2; i++) {
+            a = x[i];
+            b = x[i + 2];
+            x[i] = (a & 0x0000FFFF0000FFFFllu) |
+                ((b & 0x0000FFFF0000FFFFllu) << 16);
+            x[i + 2] = ((a >> 16) & 0x0000FFFF0000FFFFllu) |
+                (b & 0xFFFF0000FFFF0000llu);
+        }
+    }
+    for (i = 0; i < 8; i += 2) {
+        a = x[i];
+        b = x[i + 1];
+        x[i] = (a & 0x00FF00FF00FF00FFllu) |
+            ((b & 0x00FF00FF00FF00FFllu) << 8);
+        x[i + 1] = ((a >> 8) & 0x00FF00FF00FF00FFllu) |
+            (b & 0xFF00FF00FF00FF00llu);
+    }
+}
+
+// state words (little endian) to bit planes and back
+
+static inline void SBOB_BS(load)(SBOB_BS_T x[8])
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        SBOB_BS(tr8)(&x[i], &x[i]);
+    SBOB_BS(trb)(x);
+}
+
+static inline void SBOB_BS(store)(SBOB_BS_T x[8])
+{
+    int i;
+
+    SBOB_BS(trb)(x);
+    for (i = 0; i < 8; i++)
+        SBOB_BS(tr8)(&x[i], &x[i]);
+}
+"""
+
+TAIL = """
+// x = LPS(x)
+
+static inline void SBOB_BS(lps)(SBOB_BS_T x[8])
+{
+    int i;
+    SBOB_BS_T y[8];
+
+    SBOB_BS(sbox)(x);
+    for (i = 0; i < 8; i++)
+        SBOB_BS(tr8)(&y[i], &x[i]);
+    SBOB_BS(lin)(x, y);
+}
+"""
+
+# round constants as bit planes: bit 8 * j + i of plane b is bit b of
+# byte i of word j
+
+def gen_rc(rc):
+    out = ["static const uint64_t sbob_bs_rc[12][8] = {"]
+    for r in range(12):
+        x = [0] * 8
+        for j in range(8):
+            for i in range(8):
+                byte = (rc[r][j] >> (8 * i)) & 0xFF
+                for b in range(8):
+                    if byte >> b & 1:
+                        x[b] |= 1 << (8 * j + i)
+        for k in range(4):
+            s = "    {   " if k == 0 else "        "
+            s += ", ".join("0x%016Xllu" % x[b]
+                           for b in range(2 * k, 2 * k + 2))
+            s += "," if k < 3 else "  }" + ("," if r < 11 else "")
+            out.append(s)
+    out.append("};")
+    return out
+
+def main():
+    sl, rc = load_tables("sbob_tab64.c")
+    if len(sys.argv) > 1 and sys.argv[1] == "rc":
+        print("\n".join(gen_rc(rc)))
+        return
+    out = [HEAD]
+    gen_sbox(out)
+    out.append("")
+    gen_lin(out, lin_layer(sl))
+    sys.stdout.write("\n".join(out) + "\n" + TAIL)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,364 @@
+// sbob_cpu.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Runtime selection of the permutation backend. The choice is made once,
+// at first use, from cpuid. Set STRIBOB_IMPL=<name> in the environment
+// to force a specific backend, and STRIBOB_LANES=<n> to limit the width
+// of the multi-lane permutation.
+
+#include "sbob_impl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// all backends. those before SBOB_IMPL_AUTO are only used when asked
+// for by name or picked by sbob_impl_tune(), the rest are in order of
+// preference (best last)
+
+static const sbob_impl_t sbob_impl_tab[] = {
+    { "bitslice", 0,
+        sbob_pi_bs,     sbob_lps_bs,
+        NULL,           NULL,               8,  sbob_pi_x8_bs   },
+    { "unroll",   0,
+        sbob_pi_unroll, sbob_lps_gen,
+        streebog_g_gen, NULL,               0,  NULL            },
+    { "table16",  0,
+        sbob_pi_t16,    sbob_lps_t16,
+        NULL,           NULL,               0,  NULL            },
+    { "generic",  0,
+        sbob_pi_gen,    sbob_lps_gen,
+        streebog_g_gen, NULL,               0,  NULL            },
+#ifdef SBOB_X86
+    { "sse41",    SBOB_CPU_SSE41,
+        sbob_pi_sse41,  sbob_lps_sse41,
+        streebog_g_sse41, NULL,              0,  NULL            },
+    { "bmi2",     SBOB_CPU_BMI2,
+        sbob_pi_bmi2,   sbob_lps_bmi2,
+        streebog_g_bmi2, NULL,               0,  NULL            },
+    { "gfni",     SBOB_CPU_AVX512 | SBOB_CPU_AVX512BW |
+                  SBOB_CPU_VBMI | SBOB_CPU_GFNI,
+        sbob_pi_gfni,   sbob_lps_gfni,
+        streebog_g_gfni, streebog_g_n_gfni, 4,  sbob_pi_x4_gfni },
+#endif
+};
+
+#define SBOB_IMPLS ((int) (sizeof(sbob_impl_tab) / sizeof(sbob_impl_t)))
+#define SBOB_IMPL_AUTO 3
+
+static const sbob_impl_t *sbob_impl = NULL;
+
+// multi-lane backends (widest first); one lane is plain sbob_pi()
+
+static const sbob_lane_t sbob_lane_tab[] = {
+#ifdef SBOB_X86
+    { 8,    SBOB_CPU_AVX512,    sbob_pi_x8_avx512   },
+    { 4,    SBOB_CPU_AVX2,      sbob_pi_x4_avx2     },
+#endif
+    { 1,    0,                  NULL                }
+};
+
+#define SBOB_LANES ((int) (sizeof(sbob_lane_tab) / sizeof(sbob_lane_t)))
+
+static const sbob_lane_t *sbob_lane = NULL;
+
+// cpu features
+
+uint32_t sbob_cpu(void)
+{
+    static uint32_t f = 0;
+    static int done = 0;
+
+    if (done)
+        return f;
+
+#ifdef SBOB_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1"))
+        f |= SBOB_CPU_SSE41;
+    if (__builtin_cpu_supports("bmi2"))
+        f |= SBOB_CPU_BMI2;
+    if (__builtin_cpu_supports("avx2"))
+        f |= SBOB_CPU_AVX2;
+    if (__builtin_cpu_supports("avx512f"))
+        f |= SBOB_CPU_AVX512;
+    if (__builtin_cpu_supports("avx512bw"))
+        f |= SBOB_CPU_AVX512BW;
+    if (__builtin_cpu_supports("avx512vbmi"))
+        f |= SBOB_CPU_VBMI;
+    if (__builtin_cpu_supports("gfni"))
+        f |= SBOB_CPU_GFNI;
+#endif
+    done = 1;
+
+    return f;
+}
+
+// find an available backend by name
+
+static const sbob_impl_t *sbob_impl_find(const char *name)
+{
+    int i;
+    uint32_t f;
+
+    f = sbob_cpu();
+    for (i = 0; i < SBOB_IMPLS; i++) {
+        if (strcmp(sbob_impl_tab[i].name, name) == 0 &&
+            (sbob_impl_tab[i].cpu & f) == sbob_impl_tab[i].cpu)
+            return &sbob_impl_tab[i];
+    }
+
+    return NULL;
+}
+
+// the best one supported by this cpu
+
+static const sbob_impl_t *sbob_impl_best(void)
+{
+    int i;
+    uint32_t f;
+
+    f = sbob_cpu();
+    for (i = SBOB_IMPLS - 1; i > SBOB_IMPL_AUTO; i--) {
+        if ((sbob_impl_tab[i].cpu & f) == sbob_impl_tab[i].cpu)
+            break;
+    }
+
+    return &sbob_impl_tab[i];
+}
+
+// first-time selection; environment overrides cpuid
+
+static void sbob_impl_init(void)
+{
+    const char *env;
+
+    sbob_impl = sbob_impl_best();
+
+    if ((env = getenv("STRIBOB_IMPL")) != NULL && *env != 0) {
+        if (sbob_impl_set(env) != 0) {
+            fprintf(stderr, "STRIBOB_IMPL=%s not available, using %s.\n",
+                env, sbob_impl->name);
+        }
+    }
+}
+
+// select a backend by name; NULL selects the default. 0 on success
+
+int sbob_impl_set(const char *name)
+{
+    const sbob_impl_t *p;
+
+    if (name == NULL) {
+        sbob_impl_init();
+        return 0;
+    }
+    if ((p = sbob_impl_find(name)) == NULL)
+        return SBOB_ERR;
+    sbob_impl = p;
+
+    return 0;
+}
+
+// name of the current backend
+
+const char *sbob_impl_name(void)
+{
+    if (sbob_impl == NULL)
+        sbob_impl_init();
+
+    return sbob_impl->name;
+}
+
+// name of the i:th backend available on this cpu, NULL at the end
+
+const char *sbob_impl_list(int i)
+{
+    int j;
+    uint32_t f;
+
+    f = sbob_cpu();
+    for (j = 0; j < SBOB_IMPLS; j++) {
+        if ((sbob_impl_tab[j].cpu & f) == sbob_impl_tab[j].cpu) {
+            if (i-- == 0)
+                return sbob_impl_tab[j].name;
+        }
+    }
+
+    return NULL;
+}
+
+// dispatched entry points
+
+void sbob_pi(w512_t *s512)
+{
+    if (sbob_impl == NULL)
+        sbob_impl_init();
+    sbob_impl->pi(s512);
+}
+
+void sbob_lps(w512_t *y, const w512_t *a, const w512_t *b)
+{
+    if (sbob_impl == NULL)
+        sbob_impl_init();
+    sbob_impl->lps(y, a, b);
+}
+
+sbob_g_t sbob_impl_g(void)
+{
+    if (sbob_impl == NULL)
+        sbob_impl_init();
+
+    return sbob_impl->g;
+}
+
+sbob_gn_t sbob_impl_gn(void)
+{
+    if (sbob_impl == NULL)
+        sbob_impl_init();
+
+    return sbob_impl->gn;
+}
+
+// nanoseconds for "n" calls of p->pi, best of five
+
+static double sbob_impl_time(const sbob_impl_t *p, int n)
+{
+    int i, j;
+    double t, best;
+    struct timespec t0, t1;
+    w512_t s;
+
+    memset(&s, 0, sizeof(s));
+    for (i = 0; i < 8; i++)                 // warm up, build tables
+        p->pi(&s);
+
+    best = 0.0;
+    for (j = 0; j < 5; j++) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (i = 0; i < n; i++)
+            p->pi(&s);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        t = 1E9 * (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec);
+        if (j == 0 || t < best)
+            best = t;
+    }
+
+    return best;
+}
+
+// time all available backends and select the fastest one, unless the
+// choice was forced with STRIBOB_IMPL. returns its name
+
+const char *sbob_impl_tune(void)
+{
+    int i;
+    uint32_t f;
+    double t, best;
+    const char *env;
+    const sbob_impl_t *p;
+
+    if (sbob_impl == NULL)
+        sbob_impl_init();
+    if ((env = getenv("STRIBOB_IMPL")) != NULL && *env != 0)
+        return sbob_impl->name;
+
+    f = sbob_cpu();
+    p = sbob_impl;
+    best = sbob_impl_time(p, 64);
+    for (i = 0; i < SBOB_IMPLS; i++) {
+        if (&sbob_impl_tab[i] == p ||
+            (sbob_impl_tab[i].cpu & f) != sbob_impl_tab[i].cpu)
+            continue;
+        t = sbob_impl_time(&sbob_impl_tab[i], 64);
+        if (t < best) {
+            best = t;
+            sbob_impl = &sbob_impl_tab[i];
+        }
+    }
+
+    return sbob_impl->name;
+}
+
+// select the widest multi-lane kernel with at most "lanes" lanes; 0 = any
+
+int sbob_pi_lanes_set(int lanes)
+{
+    int i;
+    uint32_t f;
+
+    f = sbob_cpu();
+    for (i = 0; i < SBOB_LANES; i++) {
+        if ((lanes == 0 || sbob_lane_tab[i].lanes <= lanes) &&
+            (sbob_lane_tab[i].cpu & f) == sbob_lane_tab[i].cpu)
+            break;
+    }
+    if (i >= SBOB_LANES)
+        return SBOB_ERR;
+    sbob_lane = &sbob_lane_tab[i];
+
+    return 0;
+}
+
+static void sbob_lane_init(void)
+{
+    const char *env;
+
+    sbob_pi_lanes_set(0);
+    if ((env = getenv("STRIBOB_LANES")) != NULL && *env != 0)
+        sbob_pi_lanes_set(atoi(env));
+}
+
+// number of states handled by one multi-lane kernel call
+
+int sbob_pi_lanes(void)
+{
+    if (sbob_impl == NULL)
+        sbob_impl_init();
+    if (sbob_impl->pin != NULL)
+        return sbob_impl->lanes;
+    if (sbob_lane == NULL)
+        sbob_lane_init();
+
+    return sbob_lane->lanes;
+}
+
+// permute n independent states
+
+void sbob_pi_n(w512_t *s[], int n)
+{
+    int i, k;
+    w512_t *p[8], tmp;
+    void (*pin)(w512_t *s[]);
+
+    if (sbob_impl == NULL)
+        sbob_impl_init();
+    if (sbob_lane == NULL)
+        sbob_lane_init();
+
+    // backend's own multi-lane kernel or the generic ones
+    if (sbob_impl->pin != NULL) {
+        k = sbob_impl->lanes;
+        pin = sbob_impl->pin;
+    } else {
+        k = sbob_lane->lanes;
+        pin = sbob_lane->pin;
+    }
+
+    if (k > 1) {
+        for (; n >= k; n -= k) {
+            pin(s);
+            s += k;
+        }
+        // pad a mostly full group with a scratch state
+        if (2 * n > k) {
+            for (i = 0; i < k; i++)
+                p[i] = i < n ? s[i] : &tmp;
+            pin(p);
+            n = 0;
+        }
+    }
+
+    for (i = 0; i < n; i++)
+        sbob_pi(s[i]);
+}
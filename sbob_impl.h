@@ -0,0 +1,136 @@
+// sbob_impl.h
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Internal: permutation backends and runtime dispatch
+
+#ifndef SBOB_IMPL_H
+#define SBOB_IMPL_H
+
+#include "stribob.h"
+
+// x86 kernels are compiled with per-function target attributes
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SBOB_X86
+#endif
+
+// 64-bit words in little-endian / big-endian byte order
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define SBOB_LE64(x) (x)
+#define SBOB_BE64(x) __builtin_bswap64(x)
+#else
+#define SBOB_LE64(x) __builtin_bswap64(x)
+#define SBOB_BE64(x) (x)
+#endif
+
+// A macro to handle 64-bit constants in network (big endian) byte order
+
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+// Little Endian -- Flip Constants
+#define xT64(x) (((x##llu) >> 56) + ((x##llu) << 56) + \
+    (((x##llu) >> 40) & 0x000000000000FF00llu) + \
+    (((x##llu) >> 24) & 0x0000000000FF0000llu) + \
+    (((x##llu) >> 8)  & 0x00000000FF000000llu) + \
+    (((x##llu) << 8)  & 0x000000FF00000000llu) + \
+    (((x##llu) << 24) & 0x0000FF0000000000llu) + \
+    (((x##llu) << 40) & 0x00FF000000000000llu))
+#else
+// Big-Endian System
+#define xT64(x) (x##llu)
+#endif
+
+// sbob_tab64.c
+extern const uint64_t sbob_sl64[8][256];
+extern const uint64_t sbob_rc64[12][8];
+
+// cpu feature flags
+#define SBOB_CPU_SSE41  0x0001
+#define SBOB_CPU_BMI2   0x0002
+#define SBOB_CPU_AVX2   0x0004
+#define SBOB_CPU_AVX512 0x0008
+#define SBOB_CPU_AVX512BW 0x0010
+#define SBOB_CPU_VBMI   0x0020
+#define SBOB_CPU_GFNI   0x0040
+
+// Streebog compression function h = g_n(h, m)
+typedef void (*sbob_g_t)(w512_t *h, const w512_t *m, uint64_t n);
+
+// the same for "lanes" independent g's; ks[i] is a precomputed key
+// schedule (13 keys) for lane i, or NULL
+typedef void (*sbob_gn_t)(w512_t *h[], const w512_t *m[],
+    const uint64_t n[], const w512_t *ks[], int lanes);
+
+// backend descriptor
+typedef struct {
+    const char *name;
+    uint32_t cpu;                           // required SBOB_CPU_* flags
+    void (*pi)(w512_t *s512);               // 12-round permutation
+    void (*lps)(w512_t *y, const w512_t *a, const w512_t *b);
+                                            // y = LPS(a ^ b)
+    sbob_g_t g;                             // own Streebog g, if not 0
+    sbob_gn_t gn;                           // and up to "lanes" at once
+    int lanes;                              // own multi-lane kernel for
+    void (*pin)(w512_t *s[]);               // sbob_pi_n(), if not 0
+} sbob_impl_t;
+
+// multi-lane backend descriptor
+typedef struct {
+    int lanes;                              // states per call
+    uint32_t cpu;                           // required SBOB_CPU_* flags
+    void (*pin)(w512_t *s[]);               // permute "lanes" states
+} sbob_lane_t;
+
+// feature flags of this cpu
+uint32_t sbob_cpu(void);
+
+// LPS transform with the currently selected backend (for Streebog)
+void sbob_lps(w512_t *y, const w512_t *a, const w512_t *b);
+
+// Streebog g of the current backend, NULL to use the LPS-based one
+sbob_g_t sbob_impl_g(void);
+sbob_gn_t sbob_impl_gn(void);
+
+// sbob_pi64.c
+void sbob_pi_gen(w512_t *s512);
+void sbob_lps_gen(w512_t *y, const w512_t *a, const w512_t *b);
+void streebog_g_gen(w512_t *h, const w512_t *m, uint64_t n);
+
+// sbob_pi_unroll.c
+void sbob_pi_unroll(w512_t *s512);
+
+// sbob_pi_t16.c
+int sbob_t16_init(void);
+void sbob_pi_t16(w512_t *s512);
+void sbob_lps_t16(w512_t *y, const w512_t *a, const w512_t *b);
+
+// sbob_pi_bs.c
+void sbob_pi_bs(w512_t *s512);
+void sbob_lps_bs(w512_t *y, const w512_t *a, const w512_t *b);
+void sbob_pi_x8_bs(w512_t *s[8]);
+
+#ifdef SBOB_X86
+void sbob_pi_sse41(w512_t *s512);
+void sbob_lps_sse41(w512_t *y, const w512_t *a, const w512_t *b);
+void streebog_g_sse41(w512_t *h, const w512_t *m, uint64_t n);
+
+// sbob_pi_bmi2.c
+void sbob_pi_bmi2(w512_t *s512);
+void sbob_lps_bmi2(w512_t *y, const w512_t *a, const w512_t *b);
+void streebog_g_bmi2(w512_t *h, const w512_t *m, uint64_t n);
+
+// sbob_pi_avx2.c
+void sbob_pi_x4_avx2(w512_t *s[4]);
+
+// sbob_pi_avx512.c
+void sbob_pi_x8_avx512(w512_t *s[8]);
+
+// sbob_pi_gfni.c
+void sbob_pi_gfni(w512_t *s512);
+void sbob_lps_gfni(w512_t *y, const w512_t *a, const w512_t *b);
+void sbob_pi_x4_gfni(w512_t *s[4]);
+void streebog_g_gfni(w512_t *h, const w512_t *m, uint64_t n);
+void streebog_g_n_gfni(w512_t *h[], const w512_t *m[], const uint64_t n[],
+    const w512_t *ks[], int lanes);
+#endif
+
+#endif
@@ -3,18 +3,21 @@
 
 // Reference 64-bit GCC version + SSE4.1 XMM version of the StriBob Pi
 
-#include "stribob.h"
-
-// sbob_tab64.c
-extern const uint64_t sbob_sl64[8][256];
-extern const uint64_t sbob_rc64[12][8];
-
-// The optimized variant requires at least SSE 4.1 (Core 2, 2008 ->)
-#ifndef __SSE4_1__
+#include "sbob_impl.h"
 
 // 64-bit ANSI C version
 
-void sbob_pi(w512_t *s512)
+#define SBOB_LPS64(t, i) (          \
+    sbob_sl64[0][t.b[i]] ^          \
+    sbob_sl64[1][t.b[i + 8]] ^      \
+    sbob_sl64[2][t.b[i + 16]] ^     \
+    sbob_sl64[3][t.b[i + 24]] ^     \
+    sbob_sl64[4][t.b[i + 32]] ^     \
+    sbob_sl64[5][t.b[i + 40]] ^     \
+    sbob_sl64[6][t.b[i + 48]] ^     \
+    sbob_sl64[7][t.b[i + 56]] )
+
+void sbob_pi_gen(w512_t *s512)
 {
     int i, r;
     w512_t t;                           // temporary
@@ -24,42 +27,85 @@ void sbob_pi(w512_t *s512)
         for (i = 0; i < 8; i++)         // t = x ^ rc
             t.q[i] = s512->q[i] ^ sbob_rc64[r][i];
 
-        for (i = 0; i < 8; i++) {       // s-box and linear op
-            s512->q[i] = sbob_sl64[0][t.b[i]] ^
-                        sbob_sl64[1][t.b[i + 8]] ^
-                        sbob_sl64[2][t.b[i + 16]] ^
-                        sbob_sl64[3][t.b[i + 24]] ^
-                        sbob_sl64[4][t.b[i + 32]] ^
-                        sbob_sl64[5][t.b[i + 40]] ^
-                        sbob_sl64[6][t.b[i + 48]] ^
-                        sbob_sl64[7][t.b[i + 56]];
-        }
+        for (i = 0; i < 8; i++)         // s-box and linear op
+            s512->q[i] = SBOB_LPS64(t, i);
     }
     // clearing t deemed unnecessary
 }
 
-#else
+void sbob_lps_gen(w512_t *y, const w512_t *a, const w512_t *b)
+{
+    int i;
+    w512_t t;
+
+    for (i = 0; i < 8; i++)
+        t.q[i] = a->q[i] ^ b->q[i];
+    for (i = 0; i < 8; i++)
+        y->q[i] = SBOB_LPS64(t, i);
+}
+
+// Streebog g; the message and key chains are independent within a round
+// and are computed in the same loop
+
+void streebog_g_gen(w512_t *h, const w512_t *m, uint64_t n)
+{
+    int i, r;
+    w512_t k, s, t, u;
+
+    // k = LPS(h ^ n), n big-endian in the last word
+    for (i = 0; i < 7; i++)
+        t.q[i] = h->q[i];
+    t.q[7] = h->q[7] ^ SBOB_BE64(n);
+    for (i = 0; i < 8; i++)
+        k.q[i] = SBOB_LPS64(t, i);
+
+    for (i = 0; i < 8; i++)
+        s.q[i] = m->q[i];
+
+    for (r = 0; r < 12; r++) {
+        for (i = 0; i < 8; i++) {
+            t.q[i] = s.q[i] ^ k.q[i];
+            u.q[i] = k.q[i] ^ sbob_rc64[r][i];
+        }
+        for (i = 0; i < 8; i++) {
+            s.q[i] = SBOB_LPS64(t, i);
+            k.q[i] = SBOB_LPS64(u, i);
+        }
+    }
+
+    for (i = 0; i < 8; i++)
+        h->q[i] ^= s.q[i] ^ k.q[i] ^ m->q[i];
+}
+
+// The optimized variant requires at least SSE 4.1 (Core 2, 2008 ->)
+#ifdef SBOB_X86
 
 // SSE 4.1 version utilizing 128-bit xmm registers
 
-#include <mmintrin.h>
-#include <emmintrin.h>
-#include <smmintrin.h>
+#include <immintrin.h>
 
-#define SBOB_XMM_UMIX64(r) (        \
-    sbob_sl64[0][_mm_extract_epi8(u0, r)] ^     \
-    sbob_sl64[1][_mm_extract_epi8(u0, r + 8)] ^ \
-    sbob_sl64[2][_mm_extract_epi8(u1, r)] ^     \
-    sbob_sl64[3][_mm_extract_epi8(u1, r + 8)] ^ \
-    sbob_sl64[4][_mm_extract_epi8(u2, r)] ^     \
-    sbob_sl64[5][_mm_extract_epi8(u2, r + 8)] ^ \
-    sbob_sl64[6][_mm_extract_epi8(u3, r)] ^     \
-    sbob_sl64[7][_mm_extract_epi8(u3, r + 8)] )
+#define SBOB_XMM_UMIX64(u, r) (                         \
+    sbob_sl64[0][_mm_extract_epi8(u##0, r)] ^       \
+    sbob_sl64[1][_mm_extract_epi8(u##0, r + 8)] ^   \
+    sbob_sl64[2][_mm_extract_epi8(u##1, r)] ^       \
+    sbob_sl64[3][_mm_extract_epi8(u##1, r + 8)] ^   \
+    sbob_sl64[4][_mm_extract_epi8(u##2, r)] ^       \
+    sbob_sl64[5][_mm_extract_epi8(u##2, r + 8)] ^   \
+    sbob_sl64[6][_mm_extract_epi8(u##3, r)] ^       \
+    sbob_sl64[7][_mm_extract_epi8(u##3, r + 8)] )
 
 #define SBOB_XMM_FIT64(w0, w1) \
     _mm_insert_epi64(_mm_cvtsi64_si128(w0), (w1), 1)
 
-void sbob_pi(w512_t *s512)
+// t0..t3 = LPS(u0..u3), any register names
+#define SBOB_XMM_LPS(t, u) {                                                \
+    t##0 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(u, 0), SBOB_XMM_UMIX64(u, 1));  \
+    t##1 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(u, 2), SBOB_XMM_UMIX64(u, 3));  \
+    t##2 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(u, 4), SBOB_XMM_UMIX64(u, 5));  \
+    t##3 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(u, 6), SBOB_XMM_UMIX64(u, 7)); }
+
+__attribute__ ((target ("sse4.1")))
+void sbob_pi_sse41(w512_t *s512)
 {
     int i;
     register __m128i t0, t1, t2, t3;
@@ -79,10 +125,7 @@ void sbob_pi(w512_t *s512)
         u2 = _mm_xor_si128(t2, _mm_load_si128(&((__m128i *) sbob_rc64)[i++]));
         u3 = _mm_xor_si128(t3, _mm_load_si128(&((__m128i *) sbob_rc64)[i++]));
 
-        t0 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(0), SBOB_XMM_UMIX64(1));
-        t1 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(2), SBOB_XMM_UMIX64(3));
-        t2 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(4), SBOB_XMM_UMIX64(5));
-        t3 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(6), SBOB_XMM_UMIX64(7));
+        SBOB_XMM_LPS(t, u)
     }
 
     // store
@@ -92,5 +135,92 @@ void sbob_pi(w512_t *s512)
     _mm_store_si128(&((__m128i *) s512)[3], t3);
 }
 
-#endif
+__attribute__ ((target ("sse4.1")))
+void sbob_lps_sse41(w512_t *y, const w512_t *a, const w512_t *b)
+{
+    register __m128i t0, t1, t2, t3;
+    register __m128i u0, u1, u2, u3;
+
+    u0 = _mm_xor_si128(_mm_loadu_si128(&((const __m128i *) a)[0]),
+        _mm_loadu_si128(&((const __m128i *) b)[0]));
+    u1 = _mm_xor_si128(_mm_loadu_si128(&((const __m128i *) a)[1]),
+        _mm_loadu_si128(&((const __m128i *) b)[1]));
+    u2 = _mm_xor_si128(_mm_loadu_si128(&((const __m128i *) a)[2]),
+        _mm_loadu_si128(&((const __m128i *) b)[2]));
+    u3 = _mm_xor_si128(_mm_loadu_si128(&((const __m128i *) a)[3]),
+        _mm_loadu_si128(&((const __m128i *) b)[3]));
+
+    SBOB_XMM_LPS(t, u)
+
+    _mm_storeu_si128(&((__m128i *) y)[0], t0);
+    _mm_storeu_si128(&((__m128i *) y)[1], t1);
+    _mm_storeu_si128(&((__m128i *) y)[2], t2);
+    _mm_storeu_si128(&((__m128i *) y)[3], t3);
+}
 
+// Streebog g with the two chains interleaved in xmm registers
+
+__attribute__ ((target ("sse4.1")))
+void streebog_g_sse41(w512_t *h, const w512_t *m, uint64_t n)
+{
+    int i;
+    register __m128i s0, s1, s2, s3, k0, k1, k2, k3;
+    register __m128i u0, u1, u2, u3, v0, v1, v2, v3;
+
+    // k = LPS(h ^ n)
+    v0 = _mm_loadu_si128(&((const __m128i *) h)[0]);
+    v1 = _mm_loadu_si128(&((const __m128i *) h)[1]);
+    v2 = _mm_loadu_si128(&((const __m128i *) h)[2]);
+    v3 = _mm_xor_si128(_mm_loadu_si128(&((const __m128i *) h)[3]),
+        _mm_set_epi64x(SBOB_BE64(n), 0));
+    SBOB_XMM_LPS(k, v)
+
+    s0 = _mm_loadu_si128(&((const __m128i *) m)[0]);
+    s1 = _mm_loadu_si128(&((const __m128i *) m)[1]);
+    s2 = _mm_loadu_si128(&((const __m128i *) m)[2]);
+    s3 = _mm_loadu_si128(&((const __m128i *) m)[3]);
+
+    for (i = 0; i < 48; i += 4) {
+        u0 = _mm_xor_si128(s0, k0);
+        u1 = _mm_xor_si128(s1, k1);
+        u2 = _mm_xor_si128(s2, k2);
+        u3 = _mm_xor_si128(s3, k3);
+        v0 = _mm_xor_si128(k0,
+            _mm_load_si128(&((__m128i *) sbob_rc64)[i]));
+        v1 = _mm_xor_si128(k1,
+            _mm_load_si128(&((__m128i *) sbob_rc64)[i + 1]));
+        v2 = _mm_xor_si128(k2,
+            _mm_load_si128(&((__m128i *) sbob_rc64)[i + 2]));
+        v3 = _mm_xor_si128(k3,
+            _mm_load_si128(&((__m128i *) sbob_rc64)[i + 3]));
+
+        s0 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(u, 0), SBOB_XMM_UMIX64(u, 1));
+        k0 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(v, 0), SBOB_XMM_UMIX64(v, 1));
+        s1 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(u, 2), SBOB_XMM_UMIX64(u, 3));
+        k1 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(v, 2), SBOB_XMM_UMIX64(v, 3));
+        s2 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(u, 4), SBOB_XMM_UMIX64(u, 5));
+        k2 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(v, 4), SBOB_XMM_UMIX64(v, 5));
+        s3 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(u, 6), SBOB_XMM_UMIX64(u, 7));
+        k3 = SBOB_XMM_FIT64(SBOB_XMM_UMIX64(v, 6), SBOB_XMM_UMIX64(v, 7));
+    }
+
+    // h ^= s ^ k ^ m
+    u0 = _mm_xor_si128(_mm_xor_si128(s0, k0),
+        _mm_loadu_si128(&((const __m128i *) m)[0]));
+    u1 = _mm_xor_si128(_mm_xor_si128(s1, k1),
+        _mm_loadu_si128(&((const __m128i *) m)[1]));
+    u2 = _mm_xor_si128(_mm_xor_si128(s2, k2),
+        _mm_loadu_si128(&((const __m128i *) m)[2]));
+    u3 = _mm_xor_si128(_mm_xor_si128(s3, k3),
+        _mm_loadu_si128(&((const __m128i *) m)[3]));
+    _mm_storeu_si128(&((__m128i *) h)[0],
+        _mm_xor_si128(u0, _mm_loadu_si128(&((__m128i *) h)[0])));
+    _mm_storeu_si128(&((__m128i *) h)[1],
+        _mm_xor_si128(u1, _mm_loadu_si128(&((__m128i *) h)[1])));
+    _mm_storeu_si128(&((__m128i *) h)[2],
+        _mm_xor_si128(u2, _mm_loadu_si128(&((__m128i *) h)[2])));
+    _mm_storeu_si128(&((__m128i *) h)[3],
+        _mm_xor_si128(u3, _mm_loadu_si128(&((__m128i *) h)[3])));
+}
+
+#endif
@@ -0,0 +1,54 @@
+// sbob_pi_avx2.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Four-lane AVX2 StriBob Pi: four independent states are permuted at
+// once, with lane k of ymm register j holding word j of state k. The
+// table lookups are done with vpgatherqq.
+
+#include "sbob_impl.h"
+
+#ifdef SBOB_X86
+
+#include <immintrin.h>
+
+// y[i] ^= sl64[j][byte i of each lane of u]
+#define SBOB_X4_GATHER(j, u) {                                          \
+    for (i = 0; i < 8; i++) {                                           \
+        y[i] = _mm256_xor_si256(y[i], _mm256_i64gather_epi64(           \
+            (const long long *) sbob_sl64[j], _mm256_and_si256(         \
+            _mm256_srli_epi64(u, 8 * i), ff), 8));                      \
+    } }
+
+__attribute__ ((target ("avx2")))
+void sbob_pi_x4_avx2(w512_t *s[4])
+{
+    int i, j, r;
+    __m256i ff, u, x[8], y[8];
+
+    ff = _mm256_set1_epi64x(0xFF);
+
+    for (j = 0; j < 8; j++)
+        x[j] = _mm256_set_epi64x(s[3]->q[j], s[2]->q[j],
+            s[1]->q[j], s[0]->q[j]);
+
+    for (r = 0; r < 12; r++) {
+        for (i = 0; i < 8; i++)
+            y[i] = _mm256_setzero_si256();
+        for (j = 0; j < 8; j++) {
+            u = _mm256_xor_si256(x[j], _mm256_set1_epi64x(sbob_rc64[r][j]));
+            SBOB_X4_GATHER(j, u);
+        }
+        for (i = 0; i < 8; i++)
+            x[i] = y[i];
+    }
+
+    for (j = 0; j < 8; j++) {
+        s[0]->q[j] = _mm256_extract_epi64(x[j], 0);
+        s[1]->q[j] = _mm256_extract_epi64(x[j], 1);
+        s[2]->q[j] = _mm256_extract_epi64(x[j], 2);
+        s[3]->q[j] = _mm256_extract_epi64(x[j], 3);
+    }
+}
+
+#endif
@@ -0,0 +1,54 @@
+// sbob_pi_avx512.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Eight-lane AVX-512 StriBob Pi; lane k of zmm register j holds word j
+// of state k. Same structure as the four-lane AVX2 version.
+
+#include "sbob_impl.h"
+
+#ifdef SBOB_X86
+
+#include <immintrin.h>
+
+// y[i] ^= sl64[j][byte i of each lane of u]
+#define SBOB_X8_GATHER(j, u) {                                          \
+    for (i = 0; i < 8; i++) {                                           \
+        y[i] = _mm512_xor_si512(y[i], _mm512_i64gather_epi64(           \
+            _mm512_and_si512(_mm512_srli_epi64(u, 8 * i), ff),          \
+            (const long long *) sbob_sl64[j], 8));                      \
+    } }
+
+__attribute__ ((target ("avx512f")))
+void sbob_pi_x8_avx512(w512_t *s[8])
+{
+    int i, j, r;
+    __m512i ff, u, x[8], y[8];
+    uint64_t t[8];
+
+    ff = _mm512_set1_epi64(0xFF);
+
+    for (j = 0; j < 8; j++)
+        x[j] = _mm512_set_epi64(s[7]->q[j], s[6]->q[j],
+            s[5]->q[j], s[4]->q[j], s[3]->q[j], s[2]->q[j],
+            s[1]->q[j], s[0]->q[j]);
+
+    for (r = 0; r < 12; r++) {
+        for (i = 0; i < 8; i++)
+            y[i] = _mm512_setzero_si512();
+        for (j = 0; j < 8; j++) {
+            u = _mm512_xor_si512(x[j], _mm512_set1_epi64(sbob_rc64[r][j]));
+            SBOB_X8_GATHER(j, u);
+        }
+        for (i = 0; i < 8; i++)
+            x[i] = y[i];
+    }
+
+    for (j = 0; j < 8; j++) {
+        _mm512_storeu_si512(t, x[j]);
+        for (i = 0; i < 8; i++)
+            s[i]->q[j] = t[i];
+    }
+}
+
+#endif
@@ -0,0 +1,152 @@
+// sbob_pi_bmi2.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// BMI2 version of the StriBob Pi. The state is kept in eight 64-bit
+// registers and the table indices are extracted with shifts (shrx / rorx)
+// rather than with pextrb or byte loads from a memory temporary.
+
+#include "sbob_impl.h"
+
+#ifdef SBOB_X86
+
+// y0..y7 ^= contributions of word w at row j
+#define SBOB_BX(j, w) {                             \
+    y0 ^= sbob_sl64[j][w & 0xFF];                   \
+    y1 ^= sbob_sl64[j][(w >> 8) & 0xFF];            \
+    y2 ^= sbob_sl64[j][(w >> 16) & 0xFF];           \
+    y3 ^= sbob_sl64[j][(w >> 24) & 0xFF];           \
+    y4 ^= sbob_sl64[j][(w >> 32) & 0xFF];           \
+    y5 ^= sbob_sl64[j][(w >> 40) & 0xFF];           \
+    y6 ^= sbob_sl64[j][(w >> 48) & 0xFF];           \
+    y7 ^= sbob_sl64[j][w >> 56]; }
+
+// y = LPS(x ^ k)
+#define SBOB_BMI2_LPS(k) {                          \
+    y0 = y1 = y2 = y3 = y4 = y5 = y6 = y7 = 0;      \
+    w = x0 ^ (k)[0];                                \
+    SBOB_BX(0, w);                                  \
+    w = x1 ^ (k)[1];                                \
+    SBOB_BX(1, w);                                  \
+    w = x2 ^ (k)[2];                                \
+    SBOB_BX(2, w);                                  \
+    w = x3 ^ (k)[3];                                \
+    SBOB_BX(3, w);                                  \
+    w = x4 ^ (k)[4];                                \
+    SBOB_BX(4, w);                                  \
+    w = x5 ^ (k)[5];                                \
+    SBOB_BX(5, w);                                  \
+    w = x6 ^ (k)[6];                                \
+    SBOB_BX(6, w);                                  \
+    w = x7 ^ (k)[7];                                \
+    SBOB_BX(7, w); }
+
+__attribute__ ((target ("bmi2")))
+void sbob_pi_bmi2(w512_t *s512)
+{
+    int r;
+    uint64_t w, x0, x1, x2, x3, x4, x5, x6, x7;
+    uint64_t y0, y1, y2, y3, y4, y5, y6, y7;
+
+    x0 = s512->q[0];
+    x1 = s512->q[1];
+    x2 = s512->q[2];
+    x3 = s512->q[3];
+    x4 = s512->q[4];
+    x5 = s512->q[5];
+    x6 = s512->q[6];
+    x7 = s512->q[7];
+
+    for (r = 0; r < 12; r++) {
+        SBOB_BMI2_LPS(sbob_rc64[r]);
+        x0 = y0;
+        x1 = y1;
+        x2 = y2;
+        x3 = y3;
+        x4 = y4;
+        x5 = y5;
+        x6 = y6;
+        x7 = y7;
+    }
+
+    s512->q[0] = x0;
+    s512->q[1] = x1;
+    s512->q[2] = x2;
+    s512->q[3] = x3;
+    s512->q[4] = x4;
+    s512->q[5] = x5;
+    s512->q[6] = x6;
+    s512->q[7] = x7;
+}
+
+__attribute__ ((target ("bmi2")))
+void sbob_lps_bmi2(w512_t *y, const w512_t *a, const w512_t *b)
+{
+    uint64_t w, x0, x1, x2, x3, x4, x5, x6, x7;
+    uint64_t y0, y1, y2, y3, y4, y5, y6, y7;
+
+    x0 = a->q[0];
+    x1 = a->q[1];
+    x2 = a->q[2];
+    x3 = a->q[3];
+    x4 = a->q[4];
+    x5 = a->q[5];
+    x6 = a->q[6];
+    x7 = a->q[7];
+
+    SBOB_BMI2_LPS(b->q);
+
+    y->q[0] = y0;
+    y->q[1] = y1;
+    y->q[2] = y2;
+    y->q[3] = y3;
+    y->q[4] = y4;
+    y->q[5] = y5;
+    y->q[6] = y6;
+    y->q[7] = y7;
+}
+
+// load x0..x7 from / store y0..y7 to a w512_t
+#define SBOB_BMI2_LD(a) {                           \
+    x0 = (a)[0]; x1 = (a)[1]; x2 = (a)[2]; x3 = (a)[3];   \
+    x4 = (a)[4]; x5 = (a)[5]; x6 = (a)[6]; x7 = (a)[7]; }
+#define SBOB_BMI2_ST(a) {                           \
+    (a)[0] = y0; (a)[1] = y1; (a)[2] = y2; (a)[3] = y3;   \
+    (a)[4] = y4; (a)[5] = y5; (a)[6] = y6; (a)[7] = y7; }
+
+// Streebog g. the two LPS of a round don't depend on each other, so the
+// out-of-order core overlaps them
+
+__attribute__ ((target ("bmi2")))
+void streebog_g_bmi2(w512_t *h, const w512_t *m, uint64_t n)
+{
+    int i, r;
+    uint64_t w, x0, x1, x2, x3, x4, x5, x6, x7;
+    uint64_t y0, y1, y2, y3, y4, y5, y6, y7;
+    uint64_t k[8], s[8], t[8];
+
+    // k = LPS(h ^ n)
+    for (i = 0; i < 7; i++)
+        t[i] = 0;
+    t[7] = SBOB_BE64(n);
+    SBOB_BMI2_LD(h->q);
+    SBOB_BMI2_LPS(t);
+    SBOB_BMI2_ST(k);
+
+    for (i = 0; i < 8; i++)
+        s[i] = m->q[i];
+
+    for (r = 0; r < 12; r++) {
+        SBOB_BMI2_LD(s);                    // s = LPS(s ^ k)
+        SBOB_BMI2_LPS(k);
+        SBOB_BMI2_ST(s);
+        SBOB_BMI2_LD(k);                    // k = LPS(k ^ c[r])
+        SBOB_BMI2_LPS(sbob_rc64[r]);
+        SBOB_BMI2_ST(k);
+    }
+
+    for (i = 0; i < 8; i++)
+        h->q[i] ^= s[i] ^ k[i] ^ m->q[i];
+}
+
+#endif
@@ -0,0 +1,180 @@
+// sbob_pi_bs.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Bitsliced, table-free StriBob Pi. Much slower than the table versions
+// but has no secret-dependent memory accesses, so its speed does not
+// depend on what else competes for the L1 cache. One state fits in eight
+// 64-bit words; the multi-lane version handles eight states per call.
+
+#include "sbob_impl.h"
+
+// round constants as bit planes (python3 sbob_bs_gen.py rc)
+
+static const uint64_t sbob_bs_rc[12][8] = {
+    {   0xCDC1C0E93929AF85llu, 0xB08A4731029F877Cllu,
+        0xE57F9022FAB5E410llu, 0x09500C438E13C7FEllu,
+        0x192EC01A95C4C05Dllu, 0x34AE356695176581llu,
+        0x5D766267D36E73ECllu, 0x3310511CEC401BE9llu  },
+    {   0xF27B564EEB61D777llu, 0xC1BCF83D1C7F9BCBllu,
+        0x85D343263E02DD65llu, 0x426AB1C90CD615F9llu,
+        0xEA9B13F7B68BE4A4llu, 0xBB04460AA16F6257llu,
+        0x0BF39DA8070FAB01llu, 0xE176DA632287C63Ellu  },
+    {   0x09C8CBA5F4CAA2D1llu, 0xF67B6C47C3DD11F0llu,
+        0x0E16086C0C6DE4EFllu, 0x7360C644E2EC3F7Cllu,
+        0xAFE64CF1DD7EA607llu, 0xA8A63CAAF702BE5Bllu,
+        0x086D730BC71E14A7llu, 0xAD5743DB13A244ADllu  },
+    {   0x60DA5EB3C994B52Fllu, 0xA556FE6AA21A00CFllu,
+        0x9E4182D6EDEED067llu, 0x8E248115BDEB9317llu,
+        0x4CD3BFC2E7F8B1AEllu, 0xADED8A95DAD86D59llu,
+        0x60A621D232A9F7D5llu, 0x7CBC935B0906CD9Dllu  },
+    {   0x8AD03BDFED0BE6F5llu, 0xC26FFBAD6AB9C367llu,
+        0xFA8AAB5FEF3F1A78llu, 0x7C394323E28D3B9Fllu,
+        0xDE8BCB65CF5F0380llu, 0x79FD3AF1C501F21Ellu,
+        0xFDEB034A48819467llu, 0x48B40BC3DA20219Allu  },
+    {   0x40C7044902194DD2llu, 0x9959FF6FD6221D6Fllu,
+        0xF0D5ECDDCAC7031Fllu, 0xCB412533578959BFllu,
+        0x49BBA6FA3F1878F0llu, 0xEB9BAACE2ACB7B2Dllu,
+        0xFF4E5A03A2BE95C2llu, 0x0125F2EFFC4C86CDllu  },
+    {   0x88874E9DDBE95142llu, 0x96D22BA66F7E1C3Ellu,
+        0x6E2FC3D8067EBEDFllu, 0x19683455B4A35AB4llu,
+        0xF4A300827D239909llu, 0x10B114D42C313AB1llu,
+        0x4CCC2608A39C89D3llu, 0xC390082EC1FE1EF3llu  },
+    {   0x56B8BF2E390AC3F7llu, 0xF205887CA8E32FAFllu,
+        0xDF0BE44156F33292llu, 0x96D28D2EB9D53457llu,
+        0x9AB912B1AAFE0027llu, 0x534BA9050A2E2680llu,
+        0x4AB45309744DE25Cllu, 0x59C676BBE35606E1llu  },
+    {   0xBA3023986E3A40A3llu, 0xF1793F7A084DE4D7llu,
+        0x0425F044AD92F31Bllu, 0xC0774F5A632FDE86llu,
+        0xC92EC9B00F0FEDBDllu, 0x23C213A019971061llu,
+        0xCF9481541642DA0Cllu, 0x901C5CF19A209D82llu  },
+    {   0xACB810F7F797C461llu, 0x0CE573DFBBB4D2CFllu,
+        0xE751A617031C246Ellu, 0xD82617B11BF90B47llu,
+        0x5B7FFB4133D8D186llu, 0x8B65BD766654F74Bllu,
+        0xAD8CE5A646D6ECC4llu, 0xDECE80130EB5F41Fllu  },
+    {   0xF9A43D4E8AFC18D3llu, 0xA32B6399407E7695llu,
+        0x4CA17D0A7040CC16llu, 0xCBEDDFFB803F68F7llu,
+        0xA0C59A46900BE18Dllu, 0x6522535CC9BE5191llu,
+        0x2BFD75BCC0977CBBllu, 0x3E5387D9243BCCFEllu  },
+    {   0x70DC232DE0E1625Dllu, 0x6C658984C4A883AFllu,
+        0x420E07CD48F7102Fllu, 0x2BD15A5DC175A082llu,
+        0x76FF8239DDFCCBF1llu, 0x92236D04339EC8DDllu,
+        0x591BA14509A1A11Cllu, 0x56BB3DEEC9334D96llu  }
+};
+
+// one state per 64-bit word
+
+#define SBOB_BS_T uint64_t
+#define SBOB_BS(name) sbob_bs1_##name
+#include "sbob_bs.h"
+#undef SBOB_BS_T
+#undef SBOB_BS
+
+void sbob_pi_bs(w512_t *s512)
+{
+    int i, r;
+    uint64_t x[8];
+
+    for (i = 0; i < 8; i++)
+        x[i] = SBOB_LE64(s512->q[i]);
+    sbob_bs1_load(x);
+
+    for (r = 0; r < 12; r++) {
+        for (i = 0; i < 8; i++)
+            x[i] ^= sbob_bs_rc[r][i];
+        sbob_bs1_lps(x);
+    }
+
+    sbob_bs1_store(x);
+    for (i = 0; i < 8; i++)
+        s512->q[i] = SBOB_LE64(x[i]);
+}
+
+void sbob_lps_bs(w512_t *y, const w512_t *a, const w512_t *b)
+{
+    int i;
+    uint64_t x[8];
+
+    for (i = 0; i < 8; i++)
+        x[i] = SBOB_LE64(a->q[i] ^ b->q[i]);
+    sbob_bs1_load(x);
+    sbob_bs1_lps(x);
+    sbob_bs1_store(x);
+    for (i = 0; i < 8; i++)
+        y->q[i] = SBOB_LE64(x[i]);
+}
+
+// eight states, one per 64-bit lane (gcc vector extension)
+
+#ifdef __GNUC__
+
+typedef uint64_t sbob_bs8_t __attribute__ ((vector_size (64)));
+
+#define SBOB_BS_T sbob_bs8_t
+#define SBOB_BS(name) sbob_bs8_##name
+#include "sbob_bs.h"
+#undef SBOB_BS
+
+// the same for AVX-512 (one zmm register per bit plane)
+
+#ifdef SBOB_X86
+#pragma GCC push_options
+#pragma GCC target ("avx512f")
+#define SBOB_BS(name) sbob_bs8z_##name
+#include "sbob_bs.h"
+#undef SBOB_BS
+#pragma GCC pop_options
+#endif
+#undef SBOB_BS_T
+
+// eight lanes at once
+
+#define SBOB_BS_PI8(lps) {                                  \
+    int i, j, r;                                            \
+    sbob_bs8_t x[8];                                        \
+    for (j = 0; j < 8; j++) {                               \
+        for (i = 0; i < 8; i++)                             \
+            x[j][i] = SBOB_LE64(s[i]->q[j]);                \
+    }                                                       \
+    sbob_bs8_load(x);                                       \
+    for (r = 0; r < 12; r++) {                              \
+        for (i = 0; i < 8; i++)                             \
+            x[i] ^= sbob_bs_rc[r][i];                       \
+        lps(x);                                             \
+    }                                                       \
+    sbob_bs8_store(x);                                      \
+    for (j = 0; j < 8; j++) {                               \
+        for (i = 0; i < 8; i++)                             \
+            s[i]->q[j] = SBOB_LE64(x[j][i]);                \
+    } }
+
+#ifdef SBOB_X86
+__attribute__ ((target ("avx512f")))
+static void sbob_pi_x8_bs_avx512(w512_t *s[8])
+{
+    SBOB_BS_PI8(sbob_bs8z_lps);
+}
+#endif
+
+void sbob_pi_x8_bs(w512_t *s[8])
+{
+#ifdef SBOB_X86
+    if (sbob_cpu() & SBOB_CPU_AVX512) {
+        sbob_pi_x8_bs_avx512(s);
+        return;
+    }
+#endif
+    SBOB_BS_PI8(sbob_bs8_lps);
+}
+
+#else
+
+void sbob_pi_x8_bs(w512_t *s[8])
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        sbob_pi_bs(s[i]);
+}
+
+#endif
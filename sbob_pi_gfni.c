@@ -0,0 +1,278 @@
+// sbob_pi_gfni.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// GFNI / AVX-512 version of the StriBob Pi and Streebog g. No tables are
+// indexed by state bytes: the whole 512-bit state sits in one zmm register
+// (lane j = word j), the S-Box is two in-register vpermi2b lookups and the
+// linear layer is a sum of eight gf2p8affineqb products.
+//
+// The L layer maps input byte j of output word i through an 8x8 bit
+// matrix B[c][j] to byte c. With the S-Box output in row form, lane c of
+// the result ("column form") is the sum over k of B[c][c + k] applied to
+// lane c + k, i.e. to the state rotated by k lanes. One vpermb transposes
+// the result back to row form.
+
+#include "sbob_impl.h"
+
+#ifdef SBOB_X86
+
+#include <immintrin.h>
+
+#define SBOB_GFNI_TARGET "avx512f,avx512bw,avx512vbmi,gfni"
+
+// sbob_gfni_lm[k][c] = B[c][(c + k) % 8] in gf2p8affineqb bit order
+
+static const uint64_t sbob_gfni_lm[8][8] SBOB_ALIGN = {
+    {   0x63C7ECBA162C58B1llu, 0xBA7551188B172E5Dllu,
+        0x9224DB25D9B264C9llu, 0x82048B95A850A041llu,
+        0x3060F0D193264C98llu, 0x18317AECC183060Cllu,
+        0x56AC0F49C58A152Bllu, 0x63C7ECBA162C58B1llu  },
+    {   0x0409172A50A04182llu, 0x468C5FF9B468D1A3llu,
+        0x0D1A397EF0E1C386llu, 0x0D1A397EF0E1C386llu,
+        0x428548D3E4C89021llu, 0xFFFE03F80F1F3F7Fllu,
+        0xAE5C1682AA55AB57llu, 0x0C183D76E0C18306llu  },
+    {   0x0A14234D90214285llu, 0x8912ACD02851A244llu,
+        0x82048B95A850A041llu, 0x172E4A831122458Bllu,
+        0x122559A151A24489llu, 0x0205091120408001llu,
+        0x2347AD78D2A44891llu, 0x0205091120408001llu  },
+    {   0x8103868C983060C0llu, 0xC081C3464C983060llu,
+        0x2245A970C2840811llu, 0x254BB343A2448912llu,
+        0x29538E3542850A14llu, 0x0409172A50A04182llu,
+        0xD2A49AE71D3A74E9llu, 0xD4A884DC6DDAB56Allu  },
+    {   0x75EBA231172E5DBAllu, 0x3D7AC9AF63C78F1Ellu,
+        0x050B132240800102llu, 0x65CBF28166CC9932llu,
+        0xFAF510DA4F9F3E7Dllu, 0x63C7ECBA162C58B1llu,
+        0xC386CE5F7CF8F0E1llu, 0xB8705809AB57AE5Cllu  },
+    {   0x9F3EE25B2953A74Fllu, 0x43874CDBF4E8D0A1llu,
+        0x9932FC6059B366CCllu, 0xC183C74E5CB870E0llu,
+        0xB06172551B366CD8llu, 0x428548D3E4C89021llu,
+        0x274EBA5282040913llu, 0x122559A151A24489llu  },
+    {   0x2A54832C72E5CA95llu, 0x70E0B11357AE5CB8llu,
+        0x43874CDBF4E8D0A1llu, 0x0102040810204080llu,
+        0x18317AECC183060Cllu, 0x73E7BC0A67CE9C39llu,
+        0x4A94628F54A952A5llu, 0xA85008B9DAB56AD4llu  },
+    {   0x0C183D76E0C18306llu, 0x050B132240800102llu,
+        0xE1C3672FBE7CF8F0llu, 0x4B96668744891225llu,
+        0xDAB5B0BBAD5BB66Dllu, 0x102050B071E2C488llu,
+        0x9D3BEB4A0913274Ellu, 0x3060F0D193264C98llu  }
+};
+
+static const uint8_t sbob_gfni_pi[256] SBOB_ALIGN = {
+    0xFC, 0xEE, 0xDD, 0x11, 0xCF, 0x6E, 0x31, 0x16,
+    0xFB, 0xC4, 0xFA, 0xDA, 0x23, 0xC5, 0x04, 0x4D,
+    0xE9, 0x77, 0xF0, 0xDB, 0x93, 0x2E, 0x99, 0xBA,
+    0x17, 0x36, 0xF1, 0xBB, 0x14, 0xCD, 0x5F, 0xC1,
+    0xF9, 0x18, 0x65, 0x5A, 0xE2, 0x5C, 0xEF, 0x21,
+    0x81, 0x1C, 0x3C, 0x42, 0x8B, 0x01, 0x8E, 0x4F,
+    0x05, 0x84, 0x02, 0xAE, 0xE3, 0x6A, 0x8F, 0xA0,
+    0x06, 0x0B, 0xED, 0x98, 0x7F, 0xD4, 0xD3, 0x1F,
+    0xEB, 0x34, 0x2C, 0x51, 0xEA, 0xC8, 0x48, 0xAB,
+    0xF2, 0x2A, 0x68, 0xA2, 0xFD, 0x3A, 0xCE, 0xCC,
+    0xB5, 0x70, 0x0E, 0x56, 0x08, 0x0C, 0x76, 0x12,
+    0xBF, 0x72, 0x13, 0x47, 0x9C, 0xB7, 0x5D, 0x87,
+    0x15, 0xA1, 0x96, 0x29, 0x10, 0x7B, 0x9A, 0xC7,
+    0xF3, 0x91, 0x78, 0x6F, 0x9D, 0x9E, 0xB2, 0xB1,
+    0x32, 0x75, 0x19, 0x3D, 0xFF, 0x35, 0x8A, 0x7E,
+    0x6D, 0x54, 0xC6, 0x80, 0xC3, 0xBD, 0x0D, 0x57,
+    0xDF, 0xF5, 0x24, 0xA9, 0x3E, 0xA8, 0x43, 0xC9,
+    0xD7, 0x79, 0xD6, 0xF6, 0x7C, 0x22, 0xB9, 0x03,
+    0xE0, 0x0F, 0xEC, 0xDE, 0x7A, 0x94, 0xB0, 0xBC,
+    0xDC, 0xE8, 0x28, 0x50, 0x4E, 0x33, 0x0A, 0x4A,
+    0xA7, 0x97, 0x60, 0x73, 0x1E, 0x00, 0x62, 0x44,
+    0x1A, 0xB8, 0x38, 0x82, 0x64, 0x9F, 0x26, 0x41,
+    0xAD, 0x45, 0x46, 0x92, 0x27, 0x5E, 0x55, 0x2F,
+    0x8C, 0xA3, 0xA5, 0x7D, 0x69, 0xD5, 0x95, 0x3B,
+    0x07, 0x58, 0xB3, 0x40, 0x86, 0xAC, 0x1D, 0xF7,
+    0x30, 0x37, 0x6B, 0xE4, 0x88, 0xD9, 0xE7, 0x89,
+    0xE1, 0x1B, 0x83, 0x49, 0x4C, 0x3F, 0xF8, 0xFE,
+    0x8D, 0x53, 0xAA, 0x90, 0xCA, 0xD8, 0x85, 0x61,
+    0x20, 0x71, 0x67, 0xA4, 0x2D, 0x2B, 0x09, 0x5B,
+    0xCB, 0x9B, 0x25, 0xD0, 0xBE, 0xE5, 0x6C, 0x52,
+    0x59, 0xA6, 0x74, 0xD2, 0xE6, 0xF4, 0xB4, 0xC0,
+    0xD1, 0x66, 0xAF, 0xC2, 0x39, 0x4B, 0x63, 0xB6
+};
+
+// 8x8 byte transpose: byte 8i + j <- byte 8j + i
+
+static const uint8_t sbob_gfni_tr[64] SBOB_ALIGN = {
+    0x00, 0x08, 0x10, 0x18, 0x20, 0x28, 0x30, 0x38,
+    0x01, 0x09, 0x11, 0x19, 0x21, 0x29, 0x31, 0x39,
+    0x02, 0x0A, 0x12, 0x1A, 0x22, 0x2A, 0x32, 0x3A,
+    0x03, 0x0B, 0x13, 0x1B, 0x23, 0x2B, 0x33, 0x3B,
+    0x04, 0x0C, 0x14, 0x1C, 0x24, 0x2C, 0x34, 0x3C,
+    0x05, 0x0D, 0x15, 0x1D, 0x25, 0x2D, 0x35, 0x3D,
+    0x06, 0x0E, 0x16, 0x1E, 0x26, 0x2E, 0x36, 0x3E,
+    0x07, 0x0F, 0x17, 0x1F, 0x27, 0x2F, 0x37, 0x3F
+};
+
+// constants kept in registers for the duration of a call
+
+typedef struct {
+    __m512i p[4];                           // S-Box, 64 bytes each
+    __m512i lm[8];                          // L matrices
+    __m512i tr;                             // transpose
+} sbob_gfni_t;
+
+__attribute__ ((target (SBOB_GFNI_TARGET), always_inline))
+static inline void sbob_gfni_init(sbob_gfni_t *c)
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+        c->p[i] = _mm512_loadu_si512(&sbob_gfni_pi[64 * i]);
+    for (i = 0; i < 8; i++)
+        c->lm[i] = _mm512_loadu_si512(sbob_gfni_lm[i]);
+    c->tr = _mm512_loadu_si512(sbob_gfni_tr);
+}
+
+// LPS(x) for a state in row form
+
+#define SBOB_GFNI_ROT(k) \
+    _mm512_gf2p8affine_epi64_epi8(_mm512_alignr_epi64(y, y, k), c->lm[k], 0)
+
+__attribute__ ((target (SBOB_GFNI_TARGET), always_inline))
+static inline __m512i sbob_gfni_lps(const sbob_gfni_t *c, __m512i x)
+{
+    __m512i y, z;
+
+    // S: bit 7 of the index selects between the two halves
+    y = _mm512_mask_blend_epi8(_mm512_movepi8_mask(x),
+        _mm512_permutex2var_epi8(c->p[0], x, c->p[1]),
+        _mm512_permutex2var_epi8(c->p[2], x, c->p[3]));
+
+    // P and L
+    z = _mm512_ternarylogic_epi64(
+        _mm512_gf2p8affine_epi64_epi8(y, c->lm[0], 0),
+        SBOB_GFNI_ROT(1), SBOB_GFNI_ROT(2), 0x96);
+    z = _mm512_ternarylogic_epi64(z,
+        SBOB_GFNI_ROT(3), SBOB_GFNI_ROT(4), 0x96);
+    z = _mm512_ternarylogic_epi64(z,
+        SBOB_GFNI_ROT(5), SBOB_GFNI_ROT(6), 0x96);
+    z = _mm512_xor_si512(z, SBOB_GFNI_ROT(7));
+
+    // column form back to row form
+    return _mm512_permutexvar_epi8(c->tr, z);
+}
+
+__attribute__ ((target (SBOB_GFNI_TARGET)))
+void sbob_pi_gfni(w512_t *s512)
+{
+    int r;
+    __m512i x;
+    sbob_gfni_t c;
+
+    sbob_gfni_init(&c);
+    x = _mm512_loadu_si512(s512);
+    for (r = 0; r < 12; r++) {
+        x = sbob_gfni_lps(&c, _mm512_xor_si512(x,
+            _mm512_loadu_si512(sbob_rc64[r])));
+    }
+    _mm512_storeu_si512(s512, x);
+}
+
+__attribute__ ((target (SBOB_GFNI_TARGET)))
+void sbob_lps_gfni(w512_t *y, const w512_t *a, const w512_t *b)
+{
+    sbob_gfni_t c;
+
+    sbob_gfni_init(&c);
+    _mm512_storeu_si512(y, sbob_gfni_lps(&c, _mm512_xor_si512(
+        _mm512_loadu_si512(a), _mm512_loadu_si512(b))));
+}
+
+// independent states run interleaved to hide the latency
+
+__attribute__ ((target (SBOB_GFNI_TARGET)))
+void sbob_pi_x4_gfni(w512_t *s[4])
+{
+    int i, r;
+    __m512i rc, x[4];
+    sbob_gfni_t c;
+
+    sbob_gfni_init(&c);
+    for (i = 0; i < 4; i++)
+        x[i] = _mm512_loadu_si512(s[i]);
+    for (r = 0; r < 12; r++) {
+        rc = _mm512_loadu_si512(sbob_rc64[r]);
+        for (i = 0; i < 4; i++)
+            x[i] = sbob_gfni_lps(&c, _mm512_xor_si512(x[i], rc));
+    }
+    for (i = 0; i < 4; i++)
+        _mm512_storeu_si512(s[i], x[i]);
+}
+
+// Streebog g; the key schedule and the message chain run interleaved
+
+__attribute__ ((target (SBOB_GFNI_TARGET)))
+void streebog_g_gfni(w512_t *h, const w512_t *m, uint64_t n)
+{
+    int r;
+    __m512i k, s, x;
+    sbob_gfni_t c;
+
+    sbob_gfni_init(&c);
+
+    // n is stored big-endian in the last eight bytes
+    x = _mm512_loadu_si512(h);
+    k = sbob_gfni_lps(&c, _mm512_xor_si512(x,
+        _mm512_set_epi64(__builtin_bswap64(n), 0, 0, 0, 0, 0, 0, 0)));
+    s = _mm512_loadu_si512(m);
+
+    for (r = 0; r < 12; r++) {
+        s = sbob_gfni_lps(&c, _mm512_xor_si512(s, k));
+        k = sbob_gfni_lps(&c, _mm512_xor_si512(k,
+            _mm512_loadu_si512(sbob_rc64[r])));
+    }
+
+    x = _mm512_ternarylogic_epi64(x, s, k, 0x96);
+    _mm512_storeu_si512(h, _mm512_xor_si512(x, _mm512_loadu_si512(m)));
+}
+
+// four Streebog g's at a time (lanes past n repeat lane 0 and are not
+// stored). ks[i], if not NULL, is the precomputed key schedule of lane i
+
+__attribute__ ((target (SBOB_GFNI_TARGET)))
+void streebog_g_n_gfni(w512_t *h[], const w512_t *m[], const uint64_t n[],
+    const w512_t *ks[], int lanes)
+{
+    int i, j, r;
+    __m512i k[4], s[4], x[4], rc;
+    sbob_gfni_t c;
+
+    sbob_gfni_init(&c);
+
+    for (i = 0; i < 4; i++) {
+        j = i < lanes ? i : 0;
+        x[i] = _mm512_loadu_si512(h[j]);
+        if (ks[j] != NULL) {
+            k[i] = _mm512_loadu_si512(&ks[j][0]);
+        } else {
+            k[i] = sbob_gfni_lps(&c, _mm512_xor_si512(x[i],
+                _mm512_set_epi64(__builtin_bswap64(n[j]),
+                0, 0, 0, 0, 0, 0, 0)));
+        }
+        s[i] = _mm512_loadu_si512(m[j]);
+    }
+
+    for (r = 0; r < 12; r++) {
+        rc = _mm512_loadu_si512(sbob_rc64[r]);
+        for (i = 0; i < 4; i++)
+            s[i] = sbob_gfni_lps(&c, _mm512_xor_si512(s[i], k[i]));
+        for (i = 0; i < 4; i++) {
+            j = i < lanes ? i : 0;
+            if (ks[j] != NULL)
+                k[i] = _mm512_loadu_si512(&ks[j][r + 1]);
+            else
+                k[i] = sbob_gfni_lps(&c, _mm512_xor_si512(k[i], rc));
+        }
+    }
+
+    for (i = 0; i < lanes; i++) {
+        x[i] = _mm512_ternarylogic_epi64(x[i], s[i], k[i], 0x96);
+        _mm512_storeu_si512(h[i],
+            _mm512_xor_si512(x[i], _mm512_loadu_si512(m[i])));
+    }
+}
+
+#endif
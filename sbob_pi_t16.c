@@ -0,0 +1,90 @@
+// sbob_pi_t16.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// StriBob Pi with 16-bit indexed tables. Each table combines two rows of
+// sbob_sl64, so an output word takes four lookups instead of eight. The
+// tables (4 x 65536 x 8 bytes = 2 MB) are built from sbob_sl64 at first
+// use, so this only pays off when they stay in a large L2 / L3 cache.
+// They are built once under pthread_once(), as the first use may come
+// from several threads at the same time.
+
+#include "sbob_impl.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+static uint64_t (*sbob_t16)[0x10000] = NULL;
+static pthread_once_t sbob_t16_once = PTHREAD_ONCE_INIT;
+
+static void sbob_t16_build(void)
+{
+    int i, j, k;
+    uint64_t (*t)[0x10000];
+
+    if ((t = malloc(4 * sizeof(*t))) == NULL)
+        return;
+
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 0x100; j++) {
+            for (k = 0; k < 0x100; k++) {
+                t[i][(j << 8) | k] =
+                    sbob_sl64[2 * i][k] ^ sbob_sl64[2 * i + 1][j];
+            }
+        }
+    }
+    sbob_t16 = t;
+}
+
+// build the tables; 0 on success
+
+int sbob_t16_init(void)
+{
+    pthread_once(&sbob_t16_once, sbob_t16_build);
+
+    return sbob_t16 != NULL ? 0 : SBOB_ERR;
+}
+
+// byte i of words 2j and 2j + 1 form the index to table j
+
+#define SBOB_T16IX(t, i, j) (t.b[i + 16 * j] | (t.b[i + 16 * j + 8] << 8))
+
+#define SBOB_LPS16(t, i) (                  \
+    sbob_t16[0][SBOB_T16IX(t, i, 0)] ^      \
+    sbob_t16[1][SBOB_T16IX(t, i, 1)] ^      \
+    sbob_t16[2][SBOB_T16IX(t, i, 2)] ^      \
+    sbob_t16[3][SBOB_T16IX(t, i, 3)] )
+
+void sbob_pi_t16(w512_t *s512)
+{
+    int i, r;
+    w512_t t;
+
+    // no memory for the tables
+    if (sbob_t16_init() != 0) {
+        sbob_pi_gen(s512);
+        return;
+    }
+
+    for (r = 0; r < 12; r++) {
+        for (i = 0; i < 8; i++)
+            t.q[i] = s512->q[i] ^ sbob_rc64[r][i];
+        for (i = 0; i < 8; i++)
+            s512->q[i] = SBOB_LPS16(t, i);
+    }
+}
+
+void sbob_lps_t16(w512_t *y, const w512_t *a, const w512_t *b)
+{
+    int i;
+    w512_t t;
+
+    if (sbob_t16_init() != 0) {
+        sbob_lps_gen(y, a, b);
+        return;
+    }
+
+    for (i = 0; i < 8; i++)
+        t.q[i] = a->q[i] ^ b->q[i];
+    for (i = 0; i < 8; i++)
+        y->q[i] = SBOB_LPS16(t, i);
+}
@@ -0,0 +1,112 @@
+// sbob_pi_unroll.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Fully unrolled StriBob Pi. All twelve rounds are spelled out with the
+// round constants as immediate operands, and the state is carried from
+// round to round in local variables rather than a memory temporary.
+// The words are kept in little-endian order so that the low byte of
+// x[j] is byte 8 * j of the state on any host, as in sbob_pi_gen().
+
+#include "sbob_impl.h"
+
+// one output word from the low bytes of u0..u7, which are then shifted
+// out; the inputs die as they are consumed, keeping register use down
+#define SBOB_UC(y) {                                \
+    y = SBOB_LE64(sbob_sl64[0][u0 & 0xFF] ^         \
+        sbob_sl64[1][u1 & 0xFF] ^                   \
+        sbob_sl64[2][u2 & 0xFF] ^                   \
+        sbob_sl64[3][u3 & 0xFF] ^                   \
+        sbob_sl64[4][u4 & 0xFF] ^                   \
+        sbob_sl64[5][u5 & 0xFF] ^                   \
+        sbob_sl64[6][u6 & 0xFF] ^                   \
+        sbob_sl64[7][u7 & 0xFF]);                   \
+    u0 >>= 8;                                       \
+    u1 >>= 8;                                       \
+    u2 >>= 8;                                       \
+    u3 >>= 8;                                       \
+    u4 >>= 8;                                       \
+    u5 >>= 8;                                       \
+    u6 >>= 8;                                       \
+    u7 >>= 8; }
+
+// one round, x = LPS(x ^ c); constants in network byte order
+#define SBOB_UR(c0, c1, c2, c3, c4, c5, c6, c7) {   \
+    u0 = x0 ^ SBOB_LE64(xT64(c0));                  \
+    u1 = x1 ^ SBOB_LE64(xT64(c1));                  \
+    u2 = x2 ^ SBOB_LE64(xT64(c2));                  \
+    u3 = x3 ^ SBOB_LE64(xT64(c3));                  \
+    u4 = x4 ^ SBOB_LE64(xT64(c4));                  \
+    u5 = x5 ^ SBOB_LE64(xT64(c5));                  \
+    u6 = x6 ^ SBOB_LE64(xT64(c6));                  \
+    u7 = x7 ^ SBOB_LE64(xT64(c7));                  \
+    SBOB_UC(x0);                                    \
+    SBOB_UC(x1);                                    \
+    SBOB_UC(x2);                                    \
+    SBOB_UC(x3);                                    \
+    SBOB_UC(x4);                                    \
+    SBOB_UC(x5);                                    \
+    SBOB_UC(x6);                                    \
+    SBOB_UC(x7); }
+
+void sbob_pi_unroll(w512_t *s512)
+{
+    uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+    uint64_t u0, u1, u2, u3, u4, u5, u6, u7;
+
+    x0 = SBOB_LE64(s512->q[0]);
+    x1 = SBOB_LE64(s512->q[1]);
+    x2 = SBOB_LE64(s512->q[2]);
+    x3 = SBOB_LE64(s512->q[3]);
+    x4 = SBOB_LE64(s512->q[4]);
+    x5 = SBOB_LE64(s512->q[5]);
+    x6 = SBOB_LE64(s512->q[6]);
+    x7 = SBOB_LE64(s512->q[7]);
+
+    // same constants as sbob_rc64[0..11] in sbob_tab64.c
+    SBOB_UR(0xB1085BDA1ECADAE9, 0xEBCB2F81C0657C1F, 0x2F6A76432E45D016,
+            0x714EB88D7585C4FC, 0x4B7CE09192676901, 0xA2422A08A460D315,
+            0x05767436CC744D23, 0xDD806559F2A64507);
+    SBOB_UR(0x6FA3B58AA99D2F1A, 0x4FE39D460F70B5D7, 0xF3FEEA720A232B98,
+            0x61D55E0F16B50131, 0x9AB5176B12D69958, 0x5CB561C2DB0AA7CA,
+            0x55DDA21BD7CBCD56, 0xE679047021B19BB7);
+    SBOB_UR(0xF574DCAC2BCE2FC7, 0x0A39FC286A3D8435, 0x06F15E5F529C1F8B,
+            0xF2EA7514B1297B7B, 0xD3E20FE490359EB1, 0xC1C93A376062DB09,
+            0xC2B6F443867ADB31, 0x991E96F50ABA0AB2);
+    SBOB_UR(0xEF1FDFB3E81566D2, 0xF948E1A05D71E4DD, 0x488E857E335C3C7D,
+            0x9D721CAD685E353F, 0xA9D72C82ED03D675, 0xD8B71333935203BE,
+            0x3453EAA193E837F1, 0x220CBEBC84E3D12E);
+    SBOB_UR(0x4BEA6BACAD474799, 0x9A3F410C6CA92363, 0x7F151C1F1686104A,
+            0x359E35D7800FFFBD, 0xBFCD1747253AF5A3, 0xDFFF00B723271A16,
+            0x7A56A27EA9EA63F5, 0x601758FD7C6CFE57);
+    SBOB_UR(0xAE4FAEAE1D3AD3D9, 0x6FA4C33B7A3039C0, 0x2D66C4F95142A46C,
+            0x187F9AB49AF08EC6, 0xCFFAA6B71C9AB7B4, 0x0AF21F66C2BEC6B6,
+            0xBF71C57236904F35, 0xFA68407A46647D6E);
+    SBOB_UR(0xF4C70E16EEAAC5EC, 0x51AC86FEBF240954, 0x399EC6C7E6BF87C9,
+            0xD3473E33197A93C9, 0x0992ABC52D822C37, 0x06476983284A0504,
+            0x3517454CA23C4AF3, 0x8886564D3A14D493);
+    SBOB_UR(0x9B1F5B424D93C9A7, 0x03E7AA020C6E4141, 0x4EB7F8719C36DE1E,
+            0x89B4443B4DDBC49A, 0xF4892BCB929B0690, 0x69D18D2BD1A5C42F,
+            0x36ACC2355951A8D9, 0xA47F0DD4BF02E71E);
+    SBOB_UR(0x378F5A541631229B, 0x944C9AD8EC165FDE, 0x3A7D3A1B25894224,
+            0x3CD955B7E00D0984, 0x800A440BDBB2CEB1, 0x7B2B8A9AA6079C54,
+            0x0E38DC92CB1F2A60, 0x7261445183235ADB);
+    SBOB_UR(0xABBEDEA680056F52, 0x382AE548B2E4F3F3, 0x8941E71CFF8A78DB,
+            0x1FFFE18A1B336103, 0x9FE76702AF69334B, 0x7A1E6C303B7652F4,
+            0x3698FAD1153BB6C3, 0x74B4C7FB98459CED);
+    SBOB_UR(0x7BCD9ED0EFC889FB, 0x3002C6CD635AFE94, 0xD8FA6BBBEBAB0761,
+            0x2001802114846679, 0x8A1D71EFEA48B9CA, 0xEFBACD1D7D476E98,
+            0xDEA2594AC06FD85D, 0x6BCAA4CD81F32D1B);
+    SBOB_UR(0x378EE767F11631BA, 0xD21380B00449B17A, 0xCDA43C32BCDF1D77,
+            0xF82012D430219F9B, 0x5D80EF9D1891CC86, 0xE71DA4AA88E12852,
+            0xFAF417D5D9B21B99, 0x48BC924AF11BD720);
+
+    s512->q[0] = SBOB_LE64(x0);
+    s512->q[1] = SBOB_LE64(x1);
+    s512->q[2] = SBOB_LE64(x2);
+    s512->q[3] = SBOB_LE64(x3);
+    s512->q[4] = SBOB_LE64(x4);
+    s512->q[5] = SBOB_LE64(x5);
+    s512->q[6] = SBOB_LE64(x6);
+    s512->q[7] = SBOB_LE64(x7);
+}
@@ -3,23 +3,7 @@
 
 // Tables for 64-bit implementation of StriBob.
 
-#include "stribob.h"
-
-// A macro to handle 64-bit constants in network (big endian) byte order
-
-#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
-// Little Endian -- Flip Constants
-#define xT64(x) (((x##llu) >> 56) + ((x##llu) << 56) + \
-    (((x##llu) >> 40) & 0x000000000000FF00llu) + \
-    (((x##llu) >> 24) & 0x0000000000FF0000llu) + \
-    (((x##llu) >> 8)  & 0x00000000FF000000llu) + \
-    (((x##llu) << 8)  & 0x000000FF00000000llu) + \
-    (((x##llu) << 24) & 0x0000FF0000000000llu) + \
-    (((x##llu) << 40) & 0x00FF000000000000llu))
-#else
-// Big-Endian System
-#define xT64(x) (x##llu)
-#endif
+#include "sbob_impl.h"
 
 SBOB_ALIGN const uint64_t sbob_sl64[8][256] =
 {
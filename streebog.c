@@ -3,53 +3,100 @@
 //              See LICENSE for Licensing and Warranty information.
 
 #include "streebog.h"
+#include "sbob_impl.h"
 #include <stdio.h>
+#include <pthread.h>
 
 // sbob_tab64.c
 
-extern const uint64_t sbob_sl64[8][256];
 extern const uint64_t sbob_rc64[12][8];
 
-// LPS transform using 64-bit tables
+// n as a 512-bit big-endian number
 
-#define SBOG_LPSti64 \
-    (sbob_sl64[0][t.b[i]] ^     sbob_sl64[1][t.b[i + 8]] ^  \
-    sbob_sl64[2][t.b[i + 16]] ^ sbob_sl64[3][t.b[i + 24]] ^ \
-    sbob_sl64[4][t.b[i + 32]] ^ sbob_sl64[5][t.b[i + 40]] ^ \
-    sbob_sl64[6][t.b[i + 48]] ^ sbob_sl64[7][t.b[i + 56]])
+static void streebog_nvec(w512_t *t, uint64_t n)
+{
+    int i;
+
+    memset(t, 0, 64);
+    for (i = 63; n > 0; i--) {
+        t->b[i] = n & 0xFF;
+        n >>= 8;
+    }
+}
+
+// epsilon summation e += m (mod 2^512). e is kept as native 64-bit limbs,
+// least significant first; m is a big-endian block
+
+static void streebog_sigma(w512_t *e, const w512_t *m)
+{
+    int i;
+    uint64_t c, x, y;
+
+    c = 0;
+    for (i = 0; i < 8; i++) {
+        x = SBOB_BE64(m->q[7 - i]);
+        y = e->q[i] + c;
+        c = y < c;
+        y += x;
+        c += y < x;
+        e->q[i] = y;
+    }
+}
 
-// The "g" compression function
+// limbs <-> big-endian block, in place
 
-static void streebog_g(w512_t *h, const const w512_t *m, uint64_t n)
+static void streebog_limbs(w512_t *e)
+{
+    int i;
+    uint64_t x;
+
+    for (i = 0; i < 4; i++) {
+        x = e->q[i];
+        e->q[i] = SBOB_BE64(e->q[7 - i]);
+        e->q[7 - i] = SBOB_BE64(x);
+    }
+}
+
+// a 64-byte block of input as m; byte i goes to m.b[63 - i]
+
+static void streebog_block(w512_t *m, const uint8_t *p)
+{
+    int i;
+    uint64_t x;
+
+    for (i = 0; i < 8; i++) {
+        memcpy(&x, p + 8 * i, 8);
+        m->q[7 - i] = __builtin_bswap64(x);
+    }
+}
+
+// The "g" compression function; LPS from the selected backend
+
+static void streebog_g(w512_t *h, const w512_t *m, uint64_t n)
 {
     int i, r;
     w512_t k, s, t;
+    sbob_g_t g;
 
+    // backend with its own g
+    if ((g = sbob_impl_g()) != NULL) {
+        g(h, m, n);
+        return;
+    }
 
     // k = LPS(h ^ n)
-    memcpy(&t, h, 64);
-    for (i = 63; n > 0; i--) {
-        t.b[i] ^= n & 0xFF;
-        n >>= 8;
-    }
-    for (i = 0; i < 8; i++)
-        k.q[i] = SBOG_LPSti64;
+    streebog_nvec(&t, n);
+    sbob_lps(&k, h, &t);
 
     // s = m
     memcpy(&s, m, 64);
 
     for (r = 0; r < 12; r++) {
         // s = LPS(s ^ k)
-        for (i = 0; i < 8; i++)
-            t.q[i] = s.q[i] ^ k.q[i];
-        for (i = 0; i < 8; i++)
-            s.q[i] = SBOG_LPSti64;
+        sbob_lps(&s, &s, &k);
 
         // k = LPS(k ^ c[i])
-        for (i = 0; i < 8; i++)
-            t.q[i] = k.q[i] ^ sbob_rc64[r][i];
-        for (i = 0; i < 8; i++)
-            k.q[i] = SBOG_LPSti64;
+        sbob_lps(&k, &k, (const w512_t *) sbob_rc64[r]);
     }
 
     for (i = 0; i < 8; i++)
@@ -78,28 +125,26 @@ int streebog_init(streebog_t *sbx, int hlen)
 
 int streebog_update(streebog_t *sbx, const void *data, size_t len)
 {
-    uint64_t i;
-    int j, c;
+    size_t i;
+    int j;
 
     j = sbx->pt;
-
-    for (i = 0; i < len; i++) {
-
-        sbx->m.b[j--] = ((uint8_t *) data)[i];
+    i = 0;
+    while (i < len) {
+
+        if (j == 63 && len - i >= 64) {     // a whole block
+            streebog_block(&sbx->m, ((const uint8_t *) data) + i);
+            i += 64;
+            j = -1;
+        } else {
+            sbx->m.b[j--] = ((const uint8_t *) data)[i++];
+        }
 
         // compress
         if (j < 0) {
-
             streebog_g(&sbx->h, &sbx->m, sbx->n);
             sbx->n += 0x200;
-
-            // epsilon summation
-            c = 0;
-            for (j = 63; j >= 0; j--) {
-                c += sbx->e.b[j] + sbx->m.b[j];
-                sbx->e.b[j] = c & 0xFF;
-                c >>= 8;
-            }
+            streebog_sigma(&sbx->e, &sbx->m);
             j = 63;
         }
     }
@@ -113,7 +158,7 @@ int streebog_update(streebog_t *sbx, const void *data, size_t len)
 
 int streebog_final(void *hash, streebog_t *sbx)
 {
-    int i, c;
+    int i;
 
     // pad the message and run final g
     i = sbx->pt;
@@ -121,25 +166,14 @@ int streebog_final(void *hash, streebog_t *sbx)
     while (i >= 0)
         sbx->m.b[i--] = 0x00;
     streebog_g(&sbx->h, &sbx->m, sbx->n);
-
-    // epsilon summation
-    c = 0;
-    for (i = 63; i >= 0; i--) {
-        c += sbx->e.b[i] + sbx->m.b[i];
-        sbx->e.b[i] = c & 0xFF;
-        c >>= 8;
-    }
+    streebog_sigma(&sbx->e, &sbx->m);
 
     // finalization n
-    memset(&sbx->m, 0x00, 64);
-
     sbx->n += (63 - sbx->pt) << 3;      // total bits
-    for (i = 63; sbx->n > 0; i--) {
-        sbx->m.b[i] = sbx->n & 0xFF;
-        sbx->n >>= 8;
-    }
+    streebog_nvec(&sbx->m, sbx->n);
 
     streebog_g(&sbx->h, &sbx->m, 0);
+    streebog_limbs(&sbx->e);
     streebog_g(&sbx->h, &sbx->e, 0);
 
     // copy the result
@@ -151,6 +185,47 @@ int streebog_final(void *hash, streebog_t *sbx)
     return 1;
 }
 
+// serialize the context into STREEBOG_SAVE bytes: h, m, Sigma as a
+// big-endian block, n (big-endian), pt and hlen
+
+void streebog_save(const streebog_t *sbx, uint8_t *buf)
+{
+    int i;
+    w512_t e;
+
+    memcpy(buf, &sbx->h, 64);
+    memcpy(buf + 64, &sbx->m, 64);
+    e = sbx->e;
+    streebog_limbs(&e);
+    memcpy(buf + 128, &e, 64);
+    for (i = 0; i < 8; i++)
+        buf[192 + i] = sbx->n >> (56 - 8 * i);
+    buf[200] = sbx->pt;
+    buf[201] = sbx->hlen;
+}
+
+// restore a context saved with streebog_save(); 1 on success
+
+int streebog_load(streebog_t *sbx, const uint8_t *buf)
+{
+    int i;
+
+    if ((buf[201] != 32 && buf[201] != 64) || buf[200] > 63)
+        return 0;
+
+    memcpy(&sbx->h, buf, 64);
+    memcpy(&sbx->m, buf + 64, 64);
+    memcpy(&sbx->e, buf + 128, 64);
+    streebog_limbs(&sbx->e);
+    sbx->n = 0;
+    for (i = 0; i < 8; i++)
+        sbx->n = (sbx->n << 8) | buf[192 + i];
+    sbx->pt = buf[200];
+    sbx->hlen = buf[201];
+
+    return 1;
+}
+
 // Streebog (GOST34.11-2012). hlen = 32 (256-bit)) or hlen=64 (512-bit)
 
 void *streebog(void *hash, int hlen, const void *data, size_t len)
@@ -167,3 +242,200 @@ void *streebog(void *hash, int hlen, const void *data, size_t len)
     return hash;
 }
 
+
+// Batch hashing. Up to STREEBOG_LANES messages are in flight, and their g
+// computations are run round by round together so that the independent
+// LPS chains overlap. The first g of every message has h = IV and n = 0,
+// so its key schedule is a constant; it is computed once and cached.
+
+#define STREEBOG_LANES 4
+
+typedef struct {
+    size_t id;                              // message; n if idle
+    size_t pos;                             // bytes consumed
+    int phase;                              // 0 data, 1 N, 2 Sigma, 3 done
+    int bits;                               // data bits in m, -1 if none
+    const w512_t *ks;                       // cached key schedule or NULL
+    w512_t h, e, m;
+    uint64_t n;
+} streebog_lane_t;
+
+static w512_t streebog_ivk[2][13];          // key schedules for 256, 512
+static pthread_once_t streebog_ivk_once = PTHREAD_ONCE_INIT;
+
+// key schedules of the first block; built once under pthread_once(), as
+// streebog_n() may be first called from several threads at a time
+
+static void streebog_ivk_init(void)
+{
+    int i, r;
+    w512_t h, z;
+
+    memset(&z, 0, 64);
+    for (i = 0; i < 2; i++) {
+        memset(&h, i == 0 ? 0x01 : 0x00, 64);
+        sbob_lps(&streebog_ivk[i][0], &h, &z);
+        for (r = 0; r < 12; r++) {
+            sbob_lps(&streebog_ivk[i][r + 1], &streebog_ivk[i][r],
+                (const w512_t *) sbob_rc64[r]);
+        }
+    }
+}
+
+// g for k lanes, interleaved
+
+static void streebog_g_n(streebog_lane_t *l[], int k)
+{
+    int i, j, r;
+    w512_t s[STREEBOG_LANES], kk[STREEBOG_LANES], t;
+    const w512_t *kp[STREEBOG_LANES], *m[STREEBOG_LANES];
+    w512_t *h[STREEBOG_LANES];
+    uint64_t n[STREEBOG_LANES];
+    sbob_gn_t gn;
+
+    // backend's own multi-lane g
+    if ((gn = sbob_impl_gn()) != NULL) {
+        for (i = 0; i < k; i++) {
+            h[i] = &l[i]->h;
+            m[i] = &l[i]->m;
+            n[i] = l[i]->n;
+            kp[i] = l[i]->ks;
+        }
+        j = sbob_pi_lanes();
+        for (i = 0; i < k; i += j)
+            gn(&h[i], &m[i], &n[i], &kp[i], k - i < j ? k - i : j);
+        return;
+    }
+
+    for (i = 0; i < k; i++) {
+        if (l[i]->ks == NULL) {
+            streebog_nvec(&t, l[i]->n);
+            sbob_lps(&kk[i], &l[i]->h, &t);
+            kp[i] = &kk[i];
+        } else {
+            kp[i] = &l[i]->ks[0];
+        }
+        s[i] = l[i]->m;
+    }
+
+    for (r = 0; r < 12; r++) {
+        for (i = 0; i < k; i++)
+            sbob_lps(&s[i], &s[i], kp[i]);
+        for (i = 0; i < k; i++) {
+            if (l[i]->ks == NULL)
+                sbob_lps(&kk[i], &kk[i], (const w512_t *) sbob_rc64[r]);
+            else
+                kp[i] = &l[i]->ks[r + 1];
+        }
+    }
+
+    for (i = 0; i < k; i++) {
+        for (r = 0; r < 8; r++)
+            l[i]->h.q[r] ^= s[i].q[r] ^ kp[i]->q[r] ^ l[i]->m.q[r];
+    }
+}
+
+// set up the next g for a lane; 0 if the message is done
+
+static int streebog_lane_next(streebog_lane_t *l, const uint8_t *msg,
+    size_t len)
+{
+    size_t i, r;
+
+    l->ks = NULL;
+    l->bits = -1;
+
+    switch (l->phase) {
+
+        case 0:                             // next block, maybe padded
+            r = len - l->pos;
+            if (r > 64)
+                r = 64;
+            for (i = 0; i < r; i++)
+                l->m.b[63 - i] = msg[l->pos + i];
+            if (r < 64) {
+                l->m.b[63 - r] = 0x01;
+                for (i = r + 1; i < 64; i++)
+                    l->m.b[63 - i] = 0x00;
+                l->phase = 1;
+            }
+            if (l->pos == 0)                // h = IV, n = 0
+                l->ks = streebog_ivk[l->h.b[0] == 0x01 ? 0 : 1];
+            l->pos += r;
+            l->bits = 8 * r;
+            return 1;
+
+        case 1:                             // total bits
+            streebog_nvec(&l->m, l->n);
+            l->n = 0;
+            l->phase = 2;
+            return 1;
+
+        case 2:                             // epsilon
+            l->m = l->e;
+            streebog_limbs(&l->m);
+            l->phase = 3;
+            return 1;
+    }
+
+    return 0;
+}
+
+void streebog_n(void *hash, int hlen, const void * const msg[],
+    const size_t len[], size_t n)
+{
+    int i, k;
+    size_t nxt;
+    streebog_lane_t lane[STREEBOG_LANES], *p[STREEBOG_LANES];
+
+    if (hlen != 32 && hlen != 64)
+        return;
+    pthread_once(&streebog_ivk_once, streebog_ivk_init);
+
+    for (i = 0; i < STREEBOG_LANES; i++)
+        lane[i].id = n;                     // idle
+
+    nxt = 0;
+    while (1) {
+
+        // set up the next g of each lane, refilling finished ones
+        k = 0;
+        for (i = 0; i < STREEBOG_LANES; i++) {
+            while (1) {
+                if (lane[i].id == n) {
+                    if (nxt >= n)
+                        break;
+                    lane[i].id = nxt++;
+                    lane[i].pos = 0;
+                    lane[i].phase = 0;
+                    lane[i].n = 0;
+                    memset(&lane[i].h, hlen == 32 ? 0x01 : 0x00, 64);
+                    memset(&lane[i].e, 0x00, 64);
+                }
+                if (streebog_lane_next(&lane[i], msg[lane[i].id],
+                    len[lane[i].id])) {
+                    p[k++] = &lane[i];
+                    break;
+                }
+                memcpy(((uint8_t *) hash) + lane[i].id * hlen,
+                    &lane[i].h, hlen);
+                lane[i].id = n;
+            }
+        }
+        if (k == 0)
+            break;
+
+        streebog_g_n(p, k);
+
+        // counter and epsilon after data blocks
+        for (i = 0; i < k; i++) {
+            if (p[i]->bits >= 0) {
+                p[i]->n += p[i]->bits;
+                streebog_sigma(&p[i]->e, &p[i]->m);
+            }
+        }
+    }
+
+    // clear out sensitive stuff
+    memset(lane, 0x00, sizeof(lane));
+}
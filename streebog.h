@@ -21,7 +21,16 @@ int streebog_init(streebog_t *sbx, int hlen);
 int streebog_update(streebog_t *sbx, const void *data, size_t len);
 int streebog_final(void *hash, streebog_t *sbx);
 
+// mid-stream context as STREEBOG_SAVE bytes, for resuming later
+#define STREEBOG_SAVE 202
+void streebog_save(const streebog_t *sbx, uint8_t *buf);
+int streebog_load(streebog_t *sbx, const uint8_t *buf);
+
 // all-in-one version
 void *streebog(void *hash, int hlen, const void *data, size_t len);
 
+// hash n messages into n * hlen bytes of output
+void streebog_n(void *hash, int hlen, const void * const msg[],
+    const size_t len[], size_t n);
+
 #endif
@@ -32,17 +32,28 @@ void sbob_fin(sbob_t *sb, sbob_pad_t pad)
 
 void sbob_put(sbob_t *sb, sbob_pad_t pad, const void *in, size_t len)
 {
-    int j;
+    int j, k;
     size_t i;
+    uint64_t w;
 
     j = sb->l;
-    for (i = 0; i < len; i++) {
+    i = 0;
+    while (i < len) {
         if (j == SBOB_RATE) {
             sb->s.b[SBOB_RATE] ^= pad;
             sbob_pi(&sb->s);
             j = 0;
         }
-        sb->s.b[j++] ^= ((const uint8_t *) in)[i];
+        if (j == 0 && len - i >= SBOB_RATE) {   // a whole block
+            for (k = 0; k < SBOB_RATE / 8; k++) {
+                memcpy(&w, ((const uint8_t *) in) + i + 8 * k, 8);
+                sb->s.q[k] ^= w;
+            }
+            i += SBOB_RATE;
+            j = SBOB_RATE;
+        } else {
+            sb->s.b[j++] ^= ((const uint8_t *) in)[i++];
+        }
     }
     sb->l = j;
 }
@@ -55,13 +66,20 @@ void sbob_get(sbob_t *sb, sbob_pad_t pad, void *out, size_t len)
     size_t i;
 
     j = sb->l;
-    for (i = 0; i < len; i++) {
+    i = 0;
+    while (i < len) {
         if (j == SBOB_RATE) {
             sb->s.b[SBOB_RATE] ^= pad;
             sbob_pi(&sb->s);
             j = 0;
         }
-        ((uint8_t *) out)[i] = sb->s.b[j++];
+        if (j == 0 && len - i >= SBOB_RATE) {   // a whole block
+            memcpy(((uint8_t *) out) + i, &sb->s, SBOB_RATE);
+            i += SBOB_RATE;
+            j = SBOB_RATE;
+        } else {
+            ((uint8_t *) out)[i++] = sb->s.b[j++];
+        }
     }
     sb->l = j;
 }
@@ -95,18 +113,31 @@ int sbob_cmp(sbob_t *sb, sbob_pad_t pad, const void *in, size_t len)
 void sbob_enc(sbob_t *sb, sbob_pad_t pad,
     void *out, const void *in, size_t len)
 {
-    int j;
+    int j, k;
     size_t i;
+    uint64_t w;
 
     j = sb->l;
-    for (i = 0; i < len; i++) {
+    i = 0;
+    while (i < len) {
         if (j == SBOB_RATE) {
             sb->s.b[SBOB_RATE] ^= pad;
             sbob_pi(&sb->s);
             j = 0;
         }
-        sb->s.b[j] ^= ((const uint8_t *) in)[i];
-        ((uint8_t *) out)[i] = sb->s.b[j++];
+        if (j == 0 && len - i >= SBOB_RATE) {   // a whole block
+            for (k = 0; k < SBOB_RATE / 8; k++) {
+                memcpy(&w, ((const uint8_t *) in) + i + 8 * k, 8);
+                w ^= sb->s.q[k];
+                sb->s.q[k] = w;
+                memcpy(((uint8_t *) out) + i + 8 * k, &w, 8);
+            }
+            i += SBOB_RATE;
+            j = SBOB_RATE;
+        } else {
+            sb->s.b[j] ^= ((const uint8_t *) in)[i];
+            ((uint8_t *) out)[i++] = sb->s.b[j++];
+        }
     }
     sb->l = j;
 }
@@ -116,21 +147,259 @@ void sbob_enc(sbob_t *sb, sbob_pad_t pad,
 void sbob_dec(sbob_t *sb, sbob_pad_t pad,
     void *out, const void *in, size_t len)
 {
-    int j;
+    int j, k;
     size_t i;
     uint8_t t;
+    uint64_t w;
 
     j = sb->l;
-    for (i = 0; i < len; i++) {
+    i = 0;
+    while (i < len) {
         if (j == SBOB_RATE) {
             sb->s.b[SBOB_RATE] ^= pad;
             sbob_pi(&sb->s);
             j = 0;
         }
-        t = ((const uint8_t *) in)[i];
-        ((uint8_t *) out)[i] = sb->s.b[j] ^ t;
-        sb->s.b[j++] = t;
+        if (j == 0 && len - i >= SBOB_RATE) {   // a whole block
+            for (k = 0; k < SBOB_RATE / 8; k++) {
+                memcpy(&w, ((const uint8_t *) in) + i + 8 * k, 8);
+                sb->s.q[k] ^= w;
+                memcpy(((uint8_t *) out) + i + 8 * k, &sb->s.q[k], 8);
+                sb->s.q[k] = w;
+            }
+            i += SBOB_RATE;
+            j = SBOB_RATE;
+        } else {
+            t = ((const uint8_t *) in)[i];
+            ((uint8_t *) out)[i++] = sb->s.b[j] ^ t;
+            sb->s.b[j++] = t;
+        }
     }
     sb->l = j;
 }
+// authenticated records; kept here so that the calls above are inlined
+
+void sbob_seal(sbob_t *sb, sbob_pad_t from, const void *ad, size_t adlen,
+    void *out, const void *in, size_t len, void *tag, size_t tlen)
+{
+    sbob_put(sb, BLNK_AAD | from, ad, adlen);
+    sbob_fin(sb, BLNK_AAD | from);
+    if (len > 0) {
+        sbob_enc(sb, BLNK_MSG | from, out, in, len);
+        sbob_fin(sb, BLNK_MSG | from);
+    }
+    sbob_get(sb, BLNK_MAC | from, tag, tlen);
+    sbob_fin(sb, BLNK_MAC | from);
+}
+
+int sbob_open(sbob_t *sb, sbob_pad_t from, const void *ad, size_t adlen,
+    void *out, const void *in, size_t len, const void *tag, size_t tlen)
+{
+    int d;
+
+    sbob_put(sb, BLNK_AAD | from, ad, adlen);
+    sbob_fin(sb, BLNK_AAD | from);
+    if (len > 0) {
+        sbob_dec(sb, BLNK_MSG | from, out, in, len);
+        sbob_fin(sb, BLNK_MSG | from);
+    }
+    d = sbob_cmp(sb, BLNK_MAC | from, tag, tlen);
+    sbob_fin(sb, BLNK_MAC | from);
+
+    if (d != 0 && len > 0)                  // don't release plaintext
+        memset(out, 0x00, len);
+
+    return d;
+}
+
+// scatter-gather; fragments need not be block-aligned
+
+#ifndef _WIN32
+
+void sbob_putv(sbob_t *sb, sbob_pad_t pad,
+    const struct iovec *iov, int iovcnt)
+{
+    int i;
+
+    for (i = 0; i < iovcnt; i++)
+        sbob_put(sb, pad, iov[i].iov_base, iov[i].iov_len);
+}
+
+void sbob_encv(sbob_t *sb, sbob_pad_t pad,
+    const struct iovec *iov, int iovcnt)
+{
+    int i;
+
+    for (i = 0; i < iovcnt; i++) {
+        sbob_enc(sb, pad, iov[i].iov_base, iov[i].iov_base,
+            iov[i].iov_len);
+    }
+}
+
+void sbob_decv(sbob_t *sb, sbob_pad_t pad,
+    const struct iovec *iov, int iovcnt)
+{
+    int i;
+
+    for (i = 0; i < iovcnt; i++) {
+        sbob_dec(sb, pad, iov[i].iov_base, iov[i].iov_base,
+            iov[i].iov_len);
+    }
+}
+
+// total length of an iovec array
+
+static size_t sbob_iovlen(const struct iovec *iov, int iovcnt)
+{
+    int i;
+    size_t len;
+
+    len = 0;
+    for (i = 0; i < iovcnt; i++)
+        len += iov[i].iov_len;
+
+    return len;
+}
+
+// records like sbob_seal() / sbob_open(), payload encrypted in place
+
+void sbob_sealv(sbob_t *sb, sbob_pad_t from, const void *ad, size_t adlen,
+    const struct iovec *iov, int iovcnt, void *tag, size_t tlen)
+{
+    sbob_put(sb, BLNK_AAD | from, ad, adlen);
+    sbob_fin(sb, BLNK_AAD | from);
+    if (sbob_iovlen(iov, iovcnt) > 0) {
+        sbob_encv(sb, BLNK_MSG | from, iov, iovcnt);
+        sbob_fin(sb, BLNK_MSG | from);
+    }
+    sbob_get(sb, BLNK_MAC | from, tag, tlen);
+    sbob_fin(sb, BLNK_MAC | from);
+}
+
+int sbob_openv(sbob_t *sb, sbob_pad_t from, const void *ad, size_t adlen,
+    const struct iovec *iov, int iovcnt, const void *tag, size_t tlen)
+{
+    int i, d;
+
+    sbob_put(sb, BLNK_AAD | from, ad, adlen);
+    sbob_fin(sb, BLNK_AAD | from);
+    if (sbob_iovlen(iov, iovcnt) > 0) {
+        sbob_decv(sb, BLNK_MSG | from, iov, iovcnt);
+        sbob_fin(sb, BLNK_MSG | from);
+    }
+    d = sbob_cmp(sb, BLNK_MAC | from, tag, tlen);
+    sbob_fin(sb, BLNK_MAC | from);
+
+    if (d != 0) {                           // don't release plaintext
+        for (i = 0; i < iovcnt; i++)
+            memset(iov[i].iov_base, 0x00, iov[i].iov_len);
+    }
+
+    return d;
+}
+
+#endif
+
+// batch hash / mac. messages are fed to the lanes of sbob_pi_n(); when
+// one runs out its lane is refilled with the next message.
+
+// absorb the next (up to) SBOB_RATE bytes and set up the padding
+
+static void sbob_lane_put(sbob_t *sb, const uint8_t *in, size_t len)
+{
+    int i;
+
+    for (i = 0; i < SBOB_RATE && (size_t) i < len; i++)
+        sb->s.b[i] ^= in[i];
+    sb->l = i;
+
+    if ((size_t) i < len) {                 // more to come
+        sb->s.b[SBOB_RATE] ^= BLNK_DAT;
+    } else {                                // sbob_fin(BLNK_DAT)
+        sb->s.b[i] ^= BLNK_END;
+        sb->s.b[SBOB_RATE] ^= BLNK_DAT | BLNK_FIN;
+    }
+}
+
+void sbob_hash_n(void *hash, size_t hlen, const void *key, size_t klen,
+    const void * const msg[], const size_t len[], size_t n)
+{
+    int i, k, lanes;
+    size_t nxt, id[8], pos[8];
+    sbob_t init, sb[8];
+    w512_t *ps[8];
+
+    // common keyed prefix
+    sbob_clr(&init);
+    if (key != NULL) {
+        sbob_put(&init, BLNK_KEY, key, klen);
+        sbob_fin(&init, BLNK_KEY);
+    }
+
+    lanes = sbob_pi_lanes();
+    for (i = 0; i < lanes; i++)
+        id[i] = n;                          // idle lane
+
+    nxt = 0;
+    while (1) {
+
+        // refill idle lanes
+        for (i = 0; i < lanes && nxt < n; i++) {
+            if (id[i] == n) {
+                id[i] = nxt++;
+                pos[i] = 0;
+                sb[i] = init;
+                sbob_lane_put(&sb[i], msg[id[i]], len[id[i]]);
+            }
+        }
+
+        // permute all active lanes
+        for (i = 0, k = 0; i < lanes; i++) {
+            if (id[i] != n)
+                ps[k++] = &sb[i].s;
+        }
+        if (k == 0)
+            break;
+        sbob_pi_n(ps, k);
+
+        // output or absorb the next block
+        for (i = 0; i < lanes; i++) {
+            if (id[i] == n)
+                continue;
+            pos[i] += sb[i].l;
+            sb[i].l = 0;
+            if (pos[i] < len[id[i]]) {
+                sbob_lane_put(&sb[i], ((const uint8_t *) msg[id[i]]) +
+                    pos[i], len[id[i]] - pos[i]);
+            } else {
+                sbob_get(&sb[i], BLNK_HASH,
+                    ((uint8_t *) hash) + id[i] * hlen, hlen);
+                id[i] = n;
+            }
+        }
+    }
+
+    // clear out sensitive stuff
+    memset(&init, 0x00, sizeof(init));
+    memset(sb, 0x00, sizeof(sb));
+}
+
+// serialize the state into SBOB_SAVE bytes
+
+void sbob_save(const sbob_t *sb, uint8_t *buf)
+{
+    memcpy(buf, sb->s.b, 64);
+    buf[64] = sb->l;
+}
+
+// restore a state saved with sbob_save(); 0 on success
 
+int sbob_load(sbob_t *sb, const uint8_t *buf)
+{
+    if (buf[64] > SBOB_RATE)
+        return SBOB_ERR;
+    memcpy(sb->s.b, buf, 64);
+    sb->l = buf[64];
+
+    return 0;
+}
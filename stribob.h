@@ -23,7 +23,7 @@
 #endif
 #endif
 
-// Parameters (rate is in bytes)
+// Parameters (rate is in bytes, a multiple of 8)
 #ifndef SBOB_RATE
 #define SBOB_RATE 32
 #endif
@@ -63,9 +63,20 @@ typedef uint8_t sbob_pad_t;
 // Error codes
 #define SBOB_ERR   (-(__LINE__))
 
-// Permutation
+// Permutation (runs the backend selected at first use)
 void sbob_pi(w512_t *s512);
 
+// Backend selection. sbob_impl_set(NULL) restores the default choice
+int sbob_impl_set(const char *name);
+const char *sbob_impl_name(void);
+const char *sbob_impl_list(int i);      // i:th available, NULL at end
+const char *sbob_impl_tune(void);       // select the fastest by timing
+
+// Multi-lane permutation of n independent states
+void sbob_pi_n(w512_t *s[], int n);
+int sbob_pi_lanes(void);                // states per kernel call
+int sbob_pi_lanes_set(int lanes);       // at most "lanes"; 0 = widest
+
 // Multipurpose sponge API
 void sbob_clr(sbob_t *sb);
 void sbob_fin(sbob_t *sb, sbob_pad_t pad);
@@ -77,5 +88,41 @@ void sbob_dec(sbob_t *sb, sbob_pad_t pad,
     void *out, const void *in, size_t len);
 int sbob_cmp(sbob_t *sb, sbob_pad_t pad, const void *in, size_t len);
 
+// Mid-stream state as SBOB_SAVE bytes, for resuming later. Treat it as
+// secret if the state is keyed
+#define SBOB_SAVE 65
+void sbob_save(const sbob_t *sb, uint8_t *buf);
+int sbob_load(sbob_t *sb, const uint8_t *buf);
+
+// One authenticated record: "ad" as BLNK_AAD, "len" bytes of payload as
+// BLNK_MSG (none if len == 0) and a "tlen"-byte BLNK_MAC tag, each OR'ed
+// with "from". sbob_open() returns 0 if the tag matches; on mismatch the
+// output is cleared
+void sbob_seal(sbob_t *sb, sbob_pad_t from, const void *ad, size_t adlen,
+    void *out, const void *in, size_t len, void *tag, size_t tlen);
+int sbob_open(sbob_t *sb, sbob_pad_t from, const void *ad, size_t adlen,
+    void *out, const void *in, size_t len, const void *tag, size_t tlen);
+
+// Scatter-gather variants; sbob_encv() and sbob_decv() work in place
+#ifndef _WIN32
+#include <sys/uio.h>
+
+void sbob_putv(sbob_t *sb, sbob_pad_t pad,
+    const struct iovec *iov, int iovcnt);
+void sbob_encv(sbob_t *sb, sbob_pad_t pad,
+    const struct iovec *iov, int iovcnt);
+void sbob_decv(sbob_t *sb, sbob_pad_t pad,
+    const struct iovec *iov, int iovcnt);
+void sbob_sealv(sbob_t *sb, sbob_pad_t from, const void *ad, size_t adlen,
+    const struct iovec *iov, int iovcnt, void *tag, size_t tlen);
+int sbob_openv(sbob_t *sb, sbob_pad_t from, const void *ad, size_t adlen,
+    const struct iovec *iov, int iovcnt, const void *tag, size_t tlen);
+#endif
+
+// Batch hash / MAC of n messages into n * hlen bytes of output; same as
+// hashing each one with sbob_put(BLNK_DAT) after an optional BLNK_KEY
+void sbob_hash_n(void *hash, size_t hlen, const void *key, size_t klen,
+    const void * const msg[], const size_t len[], size_t n);
+
 #endif
 
@@ -0,0 +1,216 @@
+// tree.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Parallel tree hash. The input is split into fixed-size leaves, which
+// are hashed independently:
+//
+//      leaf i: [BLNK_KEY key] BLNK_AAD i      BLNK_DAT data  -> TREE_MD
+//      root:   [BLNK_KEY key] BLNK_AAD leaf n BLNK_DAT leaves -> CBYT_HASH
+//
+// where the AAD fields are 64-bit little-endian and "n" is the number of
+// leaves (0 for empty input). The result depends on the leaf size but
+// not on the number of threads.
+
+#include "tree.h"
+#include <pthread.h>
+
+typedef struct {
+    int fd;                                 // input
+    int seek;                               // leaves read with pread()
+    const uint8_t *key;                     // or NULL
+    size_t leaf;                            // leaf size
+    pthread_mutex_t mtx;                    // protects the rest
+    uint64_t next;                          // next leaf
+    uint64_t leaves;                        // total, once known
+    int eof, err;
+    uint8_t *md;                            // TREE_MD bytes per leaf
+    uint64_t nmd;                           // allocated
+} tree_t;
+
+// 64-bit little-endian field
+
+static void tree_u64(uint8_t *p, uint64_t x)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        p[i] = x >> (8 * i);
+}
+
+// read up to "len" bytes, stopping short only at end of file
+
+static ssize_t tree_read(int fd, uint8_t *buf, size_t len,
+    int seek, off_t off)
+{
+    size_t i;
+    ssize_t r;
+
+    for (i = 0; i < len; i += r) {
+        if (seek)
+            r = pread(fd, buf + i, len - i, off + i);
+        else
+            r = read(fd, buf + i, len - i);
+        if (r < 0 && errno == EINTR) {
+            r = 0;
+            continue;
+        }
+        if (r < 0)
+            return r;
+        if (r == 0)
+            break;
+    }
+
+    return i;
+}
+
+// start a keyed or unkeyed sponge with a 64-bit AAD field or two
+
+static void tree_init(sbob_t *sb, const uint8_t *key,
+    uint64_t a, uint64_t b, int fields)
+{
+    uint8_t f[16];
+
+    sbob_clr(sb);
+    if (key != NULL) {
+        sbob_put(sb, BLNK_KEY, key, CBYT_KEY);
+        sbob_fin(sb, BLNK_KEY);
+    }
+    tree_u64(f, a);
+    tree_u64(f + 8, b);
+    sbob_put(sb, BLNK_AAD, f, 8 * fields);
+    sbob_fin(sb, BLNK_AAD);
+}
+
+// worker: take the next leaf, read and hash it
+
+static void *tree_work(void *arg)
+{
+    tree_t *tr = (tree_t *) arg;
+    uint8_t *buf, *p, md[TREE_MD];
+    uint64_t i, n;
+    ssize_t len;
+    sbob_t sb;
+
+    if ((buf = malloc(tr->leaf)) == NULL) {
+        pthread_mutex_lock(&tr->mtx);
+        tr->err = 1;
+        pthread_mutex_unlock(&tr->mtx);
+        return NULL;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&tr->mtx);
+        if (tr->eof || tr->err) {
+            pthread_mutex_unlock(&tr->mtx);
+            break;
+        }
+        i = tr->next++;
+
+        // streams are read in order under the lock
+        if (tr->seek) {
+            if (i + 1 >= tr->leaves)
+                tr->eof = 1;
+            pthread_mutex_unlock(&tr->mtx);
+            if (i >= tr->leaves)
+                break;
+            len = tree_read(tr->fd, buf, tr->leaf, 1, i * tr->leaf);
+        } else {
+            len = tree_read(tr->fd, buf, tr->leaf, 0, 0);
+            if (len >= 0 && (size_t) len < tr->leaf) {
+                tr->eof = 1;
+                tr->leaves = len > 0 ? i + 1 : i;
+            }
+            pthread_mutex_unlock(&tr->mtx);
+            if (len == 0)
+                break;
+        }
+        if (len < 0) {
+            perror("tree_hash");
+            pthread_mutex_lock(&tr->mtx);
+            tr->err = 1;
+            pthread_mutex_unlock(&tr->mtx);
+            break;
+        }
+
+        tree_init(&sb, tr->key, i, 0, 1);
+        sbob_put(&sb, BLNK_DAT, buf, len);
+        sbob_fin(&sb, BLNK_DAT);
+        sbob_get(&sb, BLNK_HASH, md, TREE_MD);
+
+        // store the digest, growing the table if needed
+        pthread_mutex_lock(&tr->mtx);
+        if (i >= tr->nmd) {
+            n = 2 * i + 0x100;
+            if ((p = realloc(tr->md, n * TREE_MD)) == NULL) {
+                tr->err = 1;
+                pthread_mutex_unlock(&tr->mtx);
+                break;
+            }
+            tr->md = p;
+            tr->nmd = n;
+        }
+        memcpy(&tr->md[i * TREE_MD], md, TREE_MD);
+        pthread_mutex_unlock(&tr->mtx);
+    }
+
+    memset(&sb, 0, sizeof(sb));
+    free(buf);
+
+    return NULL;
+}
+
+// hash cx->fdi
+
+int tree_hash(stricat_t *cx, int keyed, size_t leaf, int threads)
+{
+    int i, n;
+    struct stat st;
+    pthread_t *tid;
+    tree_t tr;
+    sbob_t sb;
+
+    memset(&tr, 0, sizeof(tr));
+    tr.fd = cx->fdi;
+    tr.key = keyed ? cx->key : NULL;
+    tr.leaf = leaf;
+
+    // regular files are split up front
+    if (fstat(tr.fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        tr.seek = 1;
+        tr.leaves = (st.st_size + leaf - 1) / leaf;
+        tr.eof = tr.leaves == 0;
+    }
+    pthread_mutex_init(&tr.mtx, NULL);
+
+    // this thread is one of the workers
+    if (threads < 1)
+        threads = 1;
+    if ((tid = malloc(threads * sizeof(pthread_t))) == NULL)
+        return CBERRNO;
+    for (n = 0; n < threads - 1; n++) {
+        if (pthread_create(&tid[n], NULL, tree_work, &tr) != 0)
+            break;
+    }
+    tree_work(&tr);
+    for (i = 0; i < n; i++)
+        pthread_join(tid[i], NULL);
+    free(tid);
+    pthread_mutex_destroy(&tr.mtx);
+
+    if (tr.err) {
+        free(tr.md);
+        return CBERRNO;
+    }
+
+    // root
+    tree_init(&sb, tr.key, leaf, tr.leaves, 2);
+    if (tr.leaves > 0)
+        sbob_put(&sb, BLNK_DAT, tr.md, tr.leaves * TREE_MD);
+    sbob_fin(&sb, BLNK_DAT);
+    sbob_get(&sb, BLNK_HASH, cx->xfr, CBYT_HASH);
+    memset(&sb, 0, sizeof(sb));
+    free(tr.md);
+
+    return 0;
+}
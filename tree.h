@@ -0,0 +1,22 @@
+// tree.h
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+#ifndef TREE_H
+#define TREE_H
+
+#include "blnk.h"
+
+// default leaf size and its limits
+#define TREE_LEAF       0x100000
+#define TREE_LEAF_MIN   0x400
+#define TREE_LEAF_MAX   0x40000000
+
+// bytes of each leaf digest
+#define TREE_MD 32
+
+// tree hash of cx->fdi in "leaf"-byte leaves with "threads" threads,
+// keyed with cx->key if "keyed". CBYT_HASH-byte digest left in cx->xfr
+int tree_hash(stricat_t *cx, int keyed, size_t leaf, int threads);
+
+#endif
@@ -0,0 +1,483 @@
+// walk.c
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+// Recursive hashing and manifests. Directories are read by a pool of
+// threads sharing a stack of directories still to be read. The files
+// found are then hashed by as many threads, handed out in inode order,
+// which on most file systems follows the placement of the data closely
+// enough to keep the disks streaming. Results are printed at the end.
+
+#include "walk.h"
+#include "iocom.h"
+#include <pthread.h>
+#include <dirent.h>
+
+// a file
+typedef struct {
+    char *path;
+    ino_t ino;
+    int st;                                 // 0 if hashed
+    uint8_t md[64];                         // hash
+    uint8_t want[64];                       // expected hash (--check)
+} walk_ent_t;
+
+typedef struct {
+    const stricat_t *cx;
+    int op, keyed, hlen;
+    walk_ent_t *ent;                        // files found
+    size_t n, cap;
+    char **dir;                             // directories to read
+    size_t nd, capd;
+    int busy, err;                          // readers; first error
+    walk_ent_t **ord;                       // hashing order
+    size_t next;
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+} walk_t;
+
+static void walk_init(walk_t *wk, const stricat_t *cx, int op, int keyed)
+{
+    memset(wk, 0, sizeof(walk_t));
+    wk->cx = cx;
+    wk->op = op;
+    wk->keyed = keyed;
+    wk->hlen = op == 's' ? CBYT_HASH : op == 'g' ? 32 : 64;
+    pthread_mutex_init(&wk->mtx, NULL);
+    pthread_cond_init(&wk->cv, NULL);
+}
+
+static void walk_free(walk_t *wk)
+{
+    size_t i;
+
+    for (i = 0; i < wk->n; i++)
+        free(wk->ent[i].path);
+    for (i = 0; i < wk->nd; i++)
+        free(wk->dir[i]);
+    free(wk->ent);
+    free(wk->dir);
+    free(wk->ord);
+    pthread_cond_destroy(&wk->cv);
+    pthread_mutex_destroy(&wk->mtx);
+}
+
+// add a file or a directory to read; with the lock held if threads run.
+// the path is owned by wk on success
+
+static int walk_add(walk_t *wk, char *path, ino_t ino)
+{
+    size_t cap;
+    walk_ent_t *p;
+
+    if (wk->n >= wk->cap) {
+        cap = wk->cap == 0 ? 0x100 : 2 * wk->cap;
+        if ((p = realloc(wk->ent, cap * sizeof(walk_ent_t))) == NULL)
+            return CBERRNO;
+        wk->ent = p;
+        wk->cap = cap;
+    }
+    memset(&wk->ent[wk->n], 0, sizeof(walk_ent_t));
+    wk->ent[wk->n].path = path;
+    wk->ent[wk->n].ino = ino;
+    wk->n++;
+
+    return 0;
+}
+
+static int walk_push(walk_t *wk, char *path)
+{
+    size_t cap;
+    char **p;
+
+    if (wk->nd >= wk->capd) {
+        cap = wk->capd == 0 ? 0x40 : 2 * wk->capd;
+        if ((p = realloc(wk->dir, cap * sizeof(char *))) == NULL)
+            return CBERRNO;
+        wk->dir = p;
+        wk->capd = cap;
+    }
+    wk->dir[wk->nd++] = path;
+
+    return 0;
+}
+
+// "dir/name"
+
+static char *walk_path(const char *dir, const char *name)
+{
+    size_t a, b;
+    char *p;
+
+    a = strlen(dir);
+    b = strlen(name);
+    if ((p = malloc(a + b + 2)) == NULL)
+        return NULL;
+    memcpy(p, dir, a);
+    if (a > 0 && dir[a - 1] != '/')
+        p[a++] = '/';
+    memcpy(p + a, name, b + 1);
+
+    return p;
+}
+
+// read one directory. symbolic links and special files are skipped
+
+static int walk_dir(walk_t *wk, const char *dn)
+{
+    int st, err, type;
+    char *p;
+    DIR *d;
+    struct dirent *de;
+    struct stat sb;
+
+    if ((d = opendir(dn)) == NULL) {
+        perror(dn);
+        return 1;
+    }
+
+    err = 0;
+    while ((de = readdir(d)) != NULL) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+            continue;
+        if ((p = walk_path(dn, de->d_name)) == NULL) {
+            err = CBERRNO;
+            break;
+        }
+        type = de->d_type;
+        if (type == DT_UNKNOWN) {
+            if (lstat(p, &sb) != 0) {
+                perror(p);
+                free(p);
+                err = 1;
+                continue;
+            }
+            type = S_ISDIR(sb.st_mode) ? DT_DIR :
+                S_ISREG(sb.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+        if (type != DT_DIR && type != DT_REG) {
+            free(p);
+            continue;
+        }
+        // would break the manifest
+        if (strchr(p, '\n') != NULL) {
+            fprintf(stderr, "Skipping a name with a newline in %s\n", dn);
+            free(p);
+            err = 1;
+            continue;
+        }
+
+        pthread_mutex_lock(&wk->mtx);
+        if (type == DT_DIR) {
+            st = walk_push(wk, p);
+            pthread_cond_signal(&wk->cv);
+        } else {
+            st = walk_add(wk, p, de->d_ino);
+        }
+        pthread_mutex_unlock(&wk->mtx);
+        if (st != 0) {
+            free(p);
+            err = st;
+            break;
+        }
+    }
+    closedir(d);
+
+    return err;
+}
+
+// directory reader; done when the stack is empty and nobody is reading
+
+static void *walk_dirs(void *arg)
+{
+    int st;
+    char *dn;
+    walk_t *wk = (walk_t *) arg;
+
+    pthread_mutex_lock(&wk->mtx);
+    for (;;) {
+        while (wk->nd == 0 && wk->busy > 0)
+            pthread_cond_wait(&wk->cv, &wk->mtx);
+        if (wk->nd == 0)
+            break;
+        dn = wk->dir[--wk->nd];
+        wk->busy++;
+        pthread_mutex_unlock(&wk->mtx);
+
+        st = walk_dir(wk, dn);
+        free(dn);
+
+        pthread_mutex_lock(&wk->mtx);
+        if (st != 0 && wk->err == 0)
+            wk->err = st;
+        if (--wk->busy == 0)
+            pthread_cond_broadcast(&wk->cv);
+    }
+    pthread_mutex_unlock(&wk->mtx);
+
+    return NULL;
+}
+
+// hasher
+
+static void *walk_work(void *arg)
+{
+    size_t i;
+    stricat_t *wx;
+    walk_ent_t *e;
+    walk_t *wk = (walk_t *) arg;
+
+    if ((wx = malloc(sizeof(stricat_t))) == NULL)
+        return NULL;
+    memset(wx, 0x00, sizeof(stricat_t));
+    memcpy(wx->key, wk->cx->key, CBYT_KEY);
+    wx->fdi = STDIN_FILENO;
+    wx->fdo = STDOUT_FILENO;
+
+    for (;;) {
+        pthread_mutex_lock(&wk->mtx);
+        i = wk->next++;
+        pthread_mutex_unlock(&wk->mtx);
+        if (i >= wk->n)
+            break;
+
+        e = wk->ord[i];
+        if (wk->op == 's')
+            e->st = iocom_hash_file(wx, e->path, wk->keyed);
+        else
+            e->st = iocom_streebog_file(wx, e->path, wk->hlen);
+        if (e->st == 0)
+            memcpy(e->md, wx->xfr, wk->hlen);
+    }
+
+    memset(wx, 0x00, sizeof(stricat_t));
+    free(wx);
+
+    return NULL;
+}
+
+// run "fn" on "threads" threads, or on this one if none can be started
+
+static void walk_run(walk_t *wk, void *(*fn)(void *), int threads)
+{
+    int i, k;
+    pthread_t *tid;
+
+    k = 0;
+    if ((tid = malloc(threads * sizeof(pthread_t))) != NULL) {
+        for (; k < threads; k++) {
+            if (pthread_create(&tid[k], NULL, fn, wk) != 0)
+                break;
+        }
+    }
+    if (k == 0)
+        fn(wk);
+    for (i = 0; i < k; i++)
+        pthread_join(tid[i], NULL);
+    free(tid);
+}
+
+static int walk_ino_cmp(const void *a, const void *b)
+{
+    const walk_ent_t *x = *(walk_ent_t * const *) a;
+    const walk_ent_t *y = *(walk_ent_t * const *) b;
+
+    return x->ino < y->ino ? -1 : x->ino > y->ino;
+}
+
+static int walk_path_cmp(const void *a, const void *b)
+{
+    return strcmp(((const walk_ent_t *) a)->path,
+        ((const walk_ent_t *) b)->path);
+}
+
+// hash everything in wk->ent in inode order
+
+static int walk_all(walk_t *wk, int threads)
+{
+    size_t i;
+
+    if (wk->n == 0)
+        return 0;
+    if ((wk->ord = malloc(wk->n * sizeof(walk_ent_t *))) == NULL)
+        return CBERRNO;
+    for (i = 0; i < wk->n; i++) {
+        wk->ent[i].st = CBERRNO;
+        wk->ord[i] = &wk->ent[i];
+    }
+    qsort(wk->ord, wk->n, sizeof(walk_ent_t *), walk_ino_cmp);
+    wk->next = 0;
+    walk_run(wk, walk_work, threads);
+
+    return 0;
+}
+
+// write a manifest
+
+int walk_hash(stricat_t *cx, int op, int keyed, char * const fn[], int n,
+    int threads)
+{
+    int i, j, st;
+    size_t k;
+    char *p;
+    struct stat sb;
+    walk_t wk;
+
+    walk_init(&wk, cx, op, keyed);
+
+    st = 0;
+    for (i = 0; i < n; i++) {
+        if (stat(fn[i], &sb) != 0) {
+            perror(fn[i]);
+            st = 1;
+            continue;
+        }
+        if (!S_ISDIR(sb.st_mode) && !S_ISREG(sb.st_mode))
+            continue;
+        if ((p = strdup(fn[i])) == NULL ||
+            (S_ISDIR(sb.st_mode) ? walk_push(&wk, p) :
+            walk_add(&wk, p, sb.st_ino)) != 0) {
+            free(p);
+            st = CBERRNO;
+            goto done;
+        }
+    }
+    walk_run(&wk, walk_dirs, threads);
+    if (wk.err != 0)
+        st = wk.err;
+    if ((i = walk_all(&wk, threads)) != 0) {
+        st = i;
+        goto done;
+    }
+
+    qsort(wk.ent, wk.n, sizeof(walk_ent_t), walk_path_cmp);
+    for (k = 0; k < wk.n; k++) {
+        if (wk.ent[k].st != 0) {
+            if (st == 0)
+                st = wk.ent[k].st;
+            continue;
+        }
+        for (j = 0; j < wk.hlen; j++)
+            printf("%02x", wk.ent[k].md[j]);
+        printf("  %s\n", wk.ent[k].path);
+    }
+
+done:
+    walk_free(&wk);
+
+    return st;
+}
+
+// parse 2 * len hex digits
+
+static int walk_unhex(uint8_t *md, const char *s, int len)
+{
+    int i, x;
+
+    for (i = 0; i < 2 * len; i++) {
+        x = s[i];
+        if (x >= '0' && x <= '9')
+            x -= '0';
+        else if (x >= 'a' && x <= 'f')
+            x -= 'a' - 10;
+        else if (x >= 'A' && x <= 'F')
+            x -= 'A' - 10;
+        else
+            return -1;
+        md[i >> 1] = (i & 1) ? md[i >> 1] | x : x << 4;
+    }
+
+    return 0;
+}
+
+// verify a manifest
+
+int walk_check(stricat_t *cx, int op, int keyed, const char *fn,
+    int threads)
+{
+    int st, h;
+    size_t i, cap, fmt, bad, unread;
+    ssize_t len;
+    char *line, *p;
+    uint8_t md[64];
+    struct stat sb;
+    FILE *f;
+    walk_t wk;
+
+    if (strcmp(fn, "-") == 0) {
+        f = stdin;
+    } else if ((f = fopen(fn, "r")) == NULL) {
+        perror(fn);
+        return 1;
+    }
+    walk_init(&wk, cx, op, keyed);
+    h = wk.hlen;
+
+    // "hash  path" or "hash *path"
+    st = 0;
+    fmt = 0;
+    line = NULL;
+    cap = 0;
+    while ((len = getline(&line, &cap, f)) > 0) {
+        if (line[len - 1] == '\n')
+            line[--len] = 0;
+        if (len < 2 * h + 3 || line[2 * h] != ' ' ||
+            (line[2 * h + 1] != ' ' && line[2 * h + 1] != '*') ||
+            walk_unhex(md, line, h) != 0) {
+            fmt++;
+            continue;
+        }
+        if ((p = strdup(line + 2 * h + 2)) == NULL ||
+            walk_add(&wk, p, 0) != 0) {
+            free(p);
+            st = CBERRNO;
+            break;
+        }
+        memcpy(wk.ent[wk.n - 1].want, md, h);
+    }
+    free(line);
+    if (ferror(f)) {
+        perror(fn);
+        st = 1;
+    }
+    if (f != stdin)
+        fclose(f);
+    if (st != 0)
+        goto done;
+
+    for (i = 0; i < wk.n; i++) {
+        if (stat(wk.ent[i].path, &sb) == 0)
+            wk.ent[i].ino = sb.st_ino;
+    }
+    if ((st = walk_all(&wk, threads)) != 0)
+        goto done;
+
+    bad = 0;
+    unread = 0;
+    for (i = 0; i < wk.n; i++) {
+        if (wk.ent[i].st != 0) {
+            printf("%s: FAILED open or read\n", wk.ent[i].path);
+            unread++;
+        } else if (memcmp(wk.ent[i].md, wk.ent[i].want, h) != 0) {
+            printf("%s: FAILED\n", wk.ent[i].path);
+            bad++;
+        } else {
+            printf("%s: OK\n", wk.ent[i].path);
+        }
+    }
+
+    if (fmt > 0)
+        fprintf(stderr, "%s: %zu improperly formatted lines\n", fn, fmt);
+    if (unread > 0)
+        fprintf(stderr, "%s: %zu listed files could not be read\n",
+            fn, unread);
+    if (bad > 0)
+        fprintf(stderr, "%s: %zu computed hashes did NOT match\n",
+            fn, bad);
+    st = bad > 0 || unread > 0 || (fmt > 0 && wk.n == 0) ? 1 : 0;
+
+done:
+    walk_free(&wk);
+
+    return st;
+}
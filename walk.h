@@ -0,0 +1,24 @@
+// walk.h
+// 17-Oct-26    Markku-Juhani O. Saarinen <mjos@iki.fi>
+//              See LICENSE for Licensing and Warranty information.
+
+#ifndef WALK_H
+#define WALK_H
+
+#include "blnk.h"
+
+// hash the files fn[0..n-1] and all regular files below those that are
+// directories, with "threads" threads. op is 's' (STRIBOB, keyed with
+// cx->key if "keyed"), 'g' or 'G' (Streebog 256 / 512). a manifest of
+// "hash  path" lines is printed in path order; unreadable files are
+// reported and left out, and make the result nonzero
+int walk_hash(stricat_t *cx, int op, int keyed, char * const fn[], int n,
+    int threads);
+
+// verify the manifest "fn" ("-" for stdin) made with the same op,
+// printing "path: OK" or "path: FAILED" in manifest order. 0 if all
+// files match
+int walk_check(stricat_t *cx, int op, int keyed, const char *fn,
+    int threads);
+
+#endif